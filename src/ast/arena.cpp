@@ -0,0 +1,54 @@
+#include <ast/arena.hpp>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cstdint>
+
+////////////////////////////////////////////////////////////////////
+
+Arena::Arena(size_t block_size) : block_size_{block_size} {
+  FMT_ASSERT(block_size_ > 0, "Empty arena block\n");
+}
+
+Arena::~Arena() {
+  for (auto it = destructors_.rbegin(); it != destructors_.rend(); ++it) {
+    it->destroy(it->object);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void* Arena::Allocate(size_t size, size_t alignment) {
+  FMT_ASSERT(alignment <= alignof(std::max_align_t), "Over-aligned arena allocation\n");
+
+  auto aligned = [&] {
+    auto address = reinterpret_cast<uintptr_t>(cur_);
+    return reinterpret_cast<std::byte*>((address + alignment - 1) & ~(alignment - 1));
+  };
+
+  if (cur_ == nullptr || aligned() + size > end_) [[unlikely]] {
+    // Oversized requests get a block of their own
+    AddBlock(std::max(size, block_size_));
+  }
+
+  std::byte* result = aligned();
+  cur_ = result + size;
+  allocated_ += size;
+
+  return result;
+}
+
+size_t Arena::BytesAllocated() const {
+  return allocated_;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Arena::AddBlock(size_t size) {
+  // operator new[] memory is aligned for any fundamental type
+  blocks_.push_back(std::make_unique_for_overwrite<std::byte[]>(size));
+
+  cur_ = blocks_.back().get();
+  end_ = cur_ + size;
+}
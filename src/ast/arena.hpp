@@ -0,0 +1,86 @@
+#pragma once
+
+#include <type_traits>
+#include <cstddef>
+#include <utility>
+#include <memory>
+#include <vector>
+#include <new>
+
+//////////////////////////////////////////////////////////////////////
+
+// Bump-pointer storage for the nodes of one compilation unit. Nodes
+// are carved out of large blocks one after another, so a tree built
+// by the parser is (mostly) contiguous, and everything is released at
+// once when the arena goes away. There is no way to free a single node.
+//
+//   Arena arena;
+//   auto* lit = arena.Make<LiteralExpression>(token);
+//
+// Nodes which own memory themselves (e.g. std::vector members) have
+// their destructors run by the arena, in reverse order of creation.
+
+// Whether the arena must run the destructor of a T. AST nodes have a
+// virtual destructor, which is never trivial, so they go by
+// `kOwnsMemory` instead (true unless the node opts out, see TreeNode);
+// other types go by their destructor.
+template <typename T>
+inline constexpr bool kArenaDestroys = [] {
+  if constexpr (requires { T::kOwnsMemory; }) {
+    return T::kOwnsMemory;
+  } else {
+    return !std::is_trivially_destructible_v<T>;
+  }
+}();
+
+class Arena {
+ public:
+  static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+  explicit Arena(size_t block_size = kDefaultBlockSize);
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  ~Arena();
+
+  template <typename T, typename... Args>
+  T* Make(Args&&... args) {
+    void* place = Allocate(sizeof(T), alignof(T));
+    T* object = new (place) T(std::forward<Args>(args)...);
+
+    if constexpr (kArenaDestroys<T>) {
+      destructors_.push_back({object, [](void* object) {
+                                static_cast<T*>(object)->~T();
+                              }});
+    }
+
+    return object;
+  }
+
+  void* Allocate(size_t size, size_t alignment);
+
+  // Bytes handed out so far, for statistics
+  size_t BytesAllocated() const;
+
+ private:
+  void AddBlock(size_t size);
+
+ private:
+  size_t block_size_;
+
+  std::vector<std::unique_ptr<std::byte[]>> blocks_;
+  std::byte* cur_{nullptr};
+  std::byte* end_{nullptr};
+
+  size_t allocated_{0};
+
+  struct Destructor {
+    void* object;
+    void (*destroy)(void*);
+  };
+
+  std::vector<Destructor> destructors_;
+};
+
+//////////////////////////////////////////////////////////////////////
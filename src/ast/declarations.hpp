@@ -10,15 +10,24 @@
 
 class Declaration : public Statement {
  public:
+  static constexpr NodeKind kFirstKind = NodeKind::kVarDecl;
+  static constexpr NodeKind kLastKind = NodeKind::kFunDecl;
+
   virtual std::string_view GetName() = 0;
+
+ protected:
+  using Statement::Statement;
 };
 
 //////////////////////////////////////////////////////////////////////
 
 class VarDeclStatement : public Declaration {
  public:
+  static constexpr NodeKind kKind = NodeKind::kVarDecl;
+  static constexpr bool kOwnsMemory = false;
+
   VarDeclStatement(lex::Token name, Expression* rhs)
-      : name(name), rhs(rhs) {
+      : Declaration{kKind}, name(name), rhs(rhs) {
   }
 
   void Accept(Visitor* visitor) override {
@@ -41,8 +50,10 @@ class VarDeclStatement : public Declaration {
 
 class FunDeclStatement : public Declaration {
  public:
+  static constexpr NodeKind kKind = NodeKind::kFunDecl;
+
   FunDeclStatement(lex::Token name, std::vector<lex::Token> params, BlockExpression* body)
-      : name(name), params(params), body(body) {
+      : Declaration{kKind}, name(name), params(params), body(body) {
   }
 
   void Accept(Visitor* visitor) override {
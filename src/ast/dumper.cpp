@@ -0,0 +1,552 @@
+#include <ast/dumper.hpp>
+#include <ast/visitors/walker.hpp>
+
+#include <unistd.h>
+
+#include <system_error>
+#include <algorithm>
+#include <iterator>
+#include <cerrno>
+
+////////////////////////////////////////////////////////////////////
+
+// Builds the items of one node in output order, they are pushed on the
+// stack reversed afterwards
+
+class Dumper::Items {
+ public:
+  explicit Items(std::vector<Item>& items) : items_{items} {
+    items_.clear();
+  }
+
+  void Text(std::string_view text) {
+    items_.push_back({.tag = Item::Tag::kText, .text = text});
+  }
+
+  void Token(const lex::Token& token) {
+    items_.push_back({.tag = Item::Tag::kToken, .token = &token});
+  }
+
+  void Child(TreeNode* node) {
+    items_.push_back({.tag = Item::Tag::kNode, .node = node});
+  }
+
+  void Newline() {
+    items_.push_back({.tag = Item::Tag::kNewline});
+  }
+
+  void Indent() {
+    items_.push_back({.tag = Item::Tag::kIndent});
+  }
+
+  void Dedent() {
+    items_.push_back({.tag = Item::Tag::kDedent});
+  }
+
+ private:
+  std::vector<Item>& items_;
+};
+
+////////////////////////////////////////////////////////////////////
+
+static std::string_view KindName(NodeKind kind) {
+  switch (kind) {
+    case NodeKind::kExprStatement:
+      return "expr_statement";
+    case NodeKind::kAssignment:
+      return "assignment";
+    case NodeKind::kVarDecl:
+      return "var_decl";
+    case NodeKind::kFunDecl:
+      return "fun_decl";
+    case NodeKind::kComparison:
+      return "comparison";
+    case NodeKind::kBinary:
+      return "binary";
+    case NodeKind::kUnary:
+      return "unary";
+    case NodeKind::kFnCall:
+      return "fn_call";
+    case NodeKind::kBlock:
+      return "block";
+    case NodeKind::kIf:
+      return "if";
+    case NodeKind::kLiteral:
+      return "literal";
+    case NodeKind::kReturn:
+      return "return";
+    case NodeKind::kVarAccess:
+      return "var_access";
+  }
+
+  FMT_ASSERT(false, "Unknown node kind\n");
+}
+
+// The token of the node which is not a child: name, operator or value
+static const lex::Token* NodeToken(TreeNode* node) {
+  switch (node->GetKind()) {
+    case NodeKind::kVarDecl:
+      return &static_cast<VarDeclStatement*>(node)->name;
+    case NodeKind::kFunDecl:
+      return &static_cast<FunDeclStatement*>(node)->name;
+    case NodeKind::kComparison:
+      return &static_cast<ComparisonExpression*>(node)->cmp_operator;
+    case NodeKind::kBinary:
+      return &static_cast<BinaryExpression*>(node)->binary_operator;
+    case NodeKind::kUnary:
+      return &static_cast<UnaryExpression*>(node)->unary_operator;
+    case NodeKind::kFnCall:
+      return &static_cast<FnCallExpression*>(node)->name;
+    case NodeKind::kLiteral:
+      return &static_cast<LiteralExpression*>(node)->literal;
+    case NodeKind::kVarAccess:
+      return &static_cast<VarAccessExpression*>(node)->variable;
+    default:
+      return nullptr;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+
+Dumper::Dumper(int fd, DumpFormat format) : fd_{fd}, format_{format} {
+}
+
+Dumper::Dumper(DumpFormat format) : format_{format} {
+}
+
+Dumper::~Dumper() {
+  try {
+    Flush();
+  } catch (...) {
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Dumper::Dump(TreeNode* root) {
+  FMT_ASSERT(root, "Error: dumping null tree\n");
+
+  stack_.push_back({.tag = Item::Tag::kNode, .node = root});
+
+  while (!stack_.empty()) {
+    Item item = stack_.back();
+    stack_.pop_back();
+
+    switch (item.tag) {
+      case Item::Tag::kNode: {
+        Items items{scratch_};
+
+        switch (format_) {
+          case DumpFormat::kSource:
+            ExpandSource(item.node, items);
+            break;
+          case DumpFormat::kSExpression:
+            ExpandSExpression(item.node, items);
+            break;
+          case DumpFormat::kJsonLines:
+            ExpandJson(item.node, items);
+            break;
+        }
+
+        stack_.insert(stack_.end(), scratch_.rbegin(), scratch_.rend());
+        break;
+      }
+
+      case Item::Tag::kText:
+        buffer_.append(item.text);
+        break;
+
+      case Item::Tag::kToken:
+        WriteToken(*item.token);
+        break;
+
+      case Item::Tag::kNewline:
+        buffer_.push_back('\n');
+        std::fill_n(std::back_inserter(buffer_), 2 * indent_, ' ');
+        break;
+
+      case Item::Tag::kIndent:
+        ++indent_;
+        break;
+
+      case Item::Tag::kDedent:
+        --indent_;
+        break;
+    }
+
+    if (fd_ >= 0 && buffer_.size() >= kChunkSize) {
+      Flush();
+    }
+  }
+
+  buffer_.push_back('\n');
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Dumper::Flush() {
+  if (fd_ < 0) {
+    return;
+  }
+
+  const char* data = buffer_.data();
+  size_t left = buffer_.size();
+
+  while (left > 0) {
+    ssize_t written = ::write(fd_, data, left);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error(errno, std::generic_category(), "Dumping AST");
+    }
+
+    data += written;
+    left -= written;
+  }
+
+  buffer_.clear();
+}
+
+std::string_view Dumper::View() const {
+  return {buffer_.data(), buffer_.size()};
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Dumper::WriteToken(const lex::Token& token) {
+  bool json = (format_ == DumpFormat::kJsonLines);
+
+  switch (token.type) {
+    case lex::TokenType::kNumber:
+      fmt::format_to(std::back_inserter(buffer_), "{}", token.value.number);
+      break;
+
+    case lex::TokenType::kString:
+      if (json) {
+        WriteJsonString(token.value.string.View());
+      } else {
+        // The lexer has no escapes, the text goes as is
+        fmt::format_to(std::back_inserter(buffer_), "\"{}\"", token.value.string.View());
+      }
+      break;
+
+    case lex::TokenType::kIdentifier:
+      if (json) {
+        WriteJsonString(token.value.identifier.View());
+      } else {
+        buffer_.append(token.value.identifier.View());
+      }
+      break;
+
+    case lex::TokenType::kTrue:
+    case lex::TokenType::kFalse:
+      buffer_.append(std::string_view{lex::FormatTokenType(token.type)});
+      break;
+
+    default:
+      if (json) {
+        WriteJsonString(lex::FormatTokenType(token.type));
+      } else {
+        buffer_.append(std::string_view{lex::FormatTokenType(token.type)});
+      }
+  }
+}
+
+void Dumper::WriteJsonString(std::string_view text) {
+  buffer_.push_back('"');
+
+  for (char symbol : text) {
+    switch (symbol) {
+      case '"':
+        buffer_.append(std::string_view{"\\\""});
+        break;
+      case '\\':
+        buffer_.append(std::string_view{"\\\\"});
+        break;
+      case '\n':
+        buffer_.append(std::string_view{"\\n"});
+        break;
+      case '\t':
+        buffer_.append(std::string_view{"\\t"});
+        break;
+      default:
+        if (static_cast<unsigned char>(symbol) < 0x20) {
+          fmt::format_to(std::back_inserter(buffer_), "\\u{:04x}", symbol);
+        } else {
+          buffer_.push_back(symbol);
+        }
+    }
+  }
+
+  buffer_.push_back('"');
+}
+
+////////////////////////////////////////////////////////////////////
+
+// Whether the source of `expr` ends with an `if` lacking `else`, which
+// would take an `else` written right after it. Operands are already
+// parenthesized, so only `else` branches and `return` reach the end.
+static bool EndsWithOpenIf(Expression* expr) {
+  while (true) {
+    if (auto* if_expr = dyn_cast<IfExpression>(expr)) {
+      if (if_expr->false_expr == nullptr) {
+        return true;
+      }
+      expr = if_expr->false_expr;
+    } else if (auto* return_expr = dyn_cast<ReturnExpression>(expr)) {
+      expr = return_expr->expression;
+    } else {
+      return false;
+    }
+  }
+}
+
+void Dumper::ExpandSource(TreeNode* node, Items& items) {
+  // Operands which would bind differently without parentheses
+  auto operand = [&items](TreeNode* child) {
+    if (isa<BinaryExpression>(child) || isa<ComparisonExpression>(child) ||  //
+        isa<IfExpression>(child) || isa<ReturnExpression>(child)) {
+      items.Text("(");
+      items.Child(child);
+      items.Text(")");
+    } else {
+      items.Child(child);
+    }
+  };
+
+  switch (node->GetKind()) {
+    /* Statements */
+    case NodeKind::kExprStatement:
+      items.Child(static_cast<ExprStatement*>(node)->expr);
+      items.Text(";");
+      break;
+
+    case NodeKind::kAssignment: {
+      auto* assignment = static_cast<AssignmentStatement*>(node);
+      items.Child(assignment->lhs);
+      items.Text(" = ");
+      items.Child(assignment->rhs);
+      items.Text(";");
+      break;
+    }
+
+    /* Declarations */
+    case NodeKind::kVarDecl: {
+      auto* var = static_cast<VarDeclStatement*>(node);
+      items.Text("var ");
+      items.Token(var->name);
+      items.Text(" = ");
+      items.Child(var->rhs);
+      items.Text(";");
+      break;
+    }
+
+    case NodeKind::kFunDecl: {
+      auto* fun = static_cast<FunDeclStatement*>(node);
+      items.Text("fun ");
+      items.Token(fun->name);
+      for (const auto& param : fun->params) {
+        items.Text(" ");
+        items.Token(param);
+      }
+      items.Text(" = ");
+      items.Child(fun->body);
+      items.Text(";");
+      break;
+    }
+
+    /* Expressions */
+    case NodeKind::kComparison:
+    case NodeKind::kBinary: {
+      // Both have the same layout apart from the node kind
+      Expression* lhs = nullptr;
+      Expression* rhs = nullptr;
+      const lex::Token* op = NodeToken(node);
+
+      if (auto* binary = dyn_cast<BinaryExpression>(node)) {
+        lhs = binary->lhs;
+        rhs = binary->rhs;
+      } else {
+        auto* comparison = static_cast<ComparisonExpression*>(node);
+        lhs = comparison->lhs;
+        rhs = comparison->rhs;
+      }
+
+      operand(lhs);
+      items.Text(" ");
+      items.Token(*op);
+      items.Text(" ");
+      operand(rhs);
+      break;
+    }
+
+    case NodeKind::kUnary: {
+      auto* unary = static_cast<UnaryExpression*>(node);
+      items.Token(unary->unary_operator);
+      operand(unary->operand);
+      break;
+    }
+
+    case NodeKind::kFnCall: {
+      auto* call = static_cast<FnCallExpression*>(node);
+      items.Token(call->name);
+      items.Text("(");
+      for (size_t i = 0; i < call->args.size(); ++i) {
+        if (i > 0) {
+          items.Text(", ");
+        }
+        items.Child(call->args[i]);
+      }
+      items.Text(")");
+      break;
+    }
+
+    case NodeKind::kBlock: {
+      auto* block = static_cast<BlockExpression*>(node);
+      if (block->statements.empty()) {
+        items.Text("{}");
+        break;
+      }
+
+      items.Text("{");
+      items.Indent();
+      for (auto* statement : block->statements) {
+        items.Newline();
+        items.Child(statement);
+      }
+      items.Dedent();
+      items.Newline();
+      items.Text("}");
+      break;
+    }
+
+    case NodeKind::kIf: {
+      auto* if_expr = static_cast<IfExpression*>(node);
+      items.Text("if ");
+      items.Child(if_expr->condition_expr);
+      items.Text(" then ");
+
+      // `else` would go to the inner `if`
+      if (if_expr->false_expr != nullptr && EndsWithOpenIf(if_expr->true_expr)) {
+        items.Text("(");
+        items.Child(if_expr->true_expr);
+        items.Text(")");
+      } else {
+        items.Child(if_expr->true_expr);
+      }
+
+      if (if_expr->false_expr != nullptr) {
+        items.Text(" else ");
+        items.Child(if_expr->false_expr);
+      }
+      break;
+    }
+
+    case NodeKind::kLiteral:
+    case NodeKind::kVarAccess:
+      items.Token(*NodeToken(node));
+      break;
+
+    case NodeKind::kReturn:
+      items.Text("return ");
+      items.Child(static_cast<ReturnExpression*>(node)->expression);
+      break;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Dumper::ExpandSExpression(TreeNode* node, Items& items) {
+  if (isa<LiteralExpression>(node) || isa<VarAccessExpression>(node)) {
+    items.Token(*NodeToken(node));
+    return;
+  }
+
+  items.Text("(");
+  items.Text(KindName(node->GetKind()));
+
+  if (auto* token = NodeToken(node)) {
+    items.Text(" ");
+    items.Token(*token);
+  }
+
+  if (auto* fun = dyn_cast<FunDeclStatement>(node)) {
+    items.Text(" (");
+    for (size_t i = 0; i < fun->params.size(); ++i) {
+      if (i > 0) {
+        items.Text(" ");
+      }
+      items.Token(fun->params[i]);
+    }
+    items.Text(")");
+  }
+
+  bool missing_else = isa<IfExpression>(node) && static_cast<IfExpression*>(node)->false_expr == nullptr;
+
+  ForEachChild(node, [&items](TreeNode* child) {
+    items.Text(" ");
+    items.Child(child);
+  });
+
+  if (missing_else) {
+    items.Text(" ()");
+  }
+
+  items.Text(")");
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Dumper::ExpandJson(TreeNode* node, Items& items) {
+  items.Text("{\"kind\":\"");
+  items.Text(KindName(node->GetKind()));
+  items.Text("\"");
+
+  if (auto* token = NodeToken(node)) {
+    bool value = isa<LiteralExpression>(node);
+    bool op = isa<BinaryExpression>(node) || isa<ComparisonExpression>(node) || isa<UnaryExpression>(node);
+
+    items.Text(value ? ",\"value\":" : op ? ",\"op\":" : ",\"name\":");
+    items.Token(*token);
+  }
+
+  if (auto* fun = dyn_cast<FunDeclStatement>(node)) {
+    items.Text(",\"params\":[");
+    for (size_t i = 0; i < fun->params.size(); ++i) {
+      if (i > 0) {
+        items.Text(",");
+      }
+      items.Token(fun->params[i]);
+    }
+    items.Text("]");
+  }
+
+  if (isa<LiteralExpression>(node) || isa<VarAccessExpression>(node)) {
+    items.Text("}");
+    return;
+  }
+
+  items.Text(",\"children\":[");
+
+  bool first = true;
+  ForEachChild(node, [&](TreeNode* child) {
+    items.Text(first ? "" : ",");
+    items.Child(child);
+    first = false;
+  });
+
+  if (auto* if_expr = dyn_cast<IfExpression>(node); if_expr && if_expr->false_expr == nullptr) {
+    items.Text(",null");
+  }
+
+  items.Text("]}");
+}
+
+////////////////////////////////////////////////////////////////////
+
+std::string DumpToString(TreeNode* root, DumpFormat format) {
+  Dumper dumper{format};
+  dumper.Dump(root);
+  return std::string{dumper.View()};
+}
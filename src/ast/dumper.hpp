@@ -0,0 +1,105 @@
+#pragma once
+
+#include <ast/declarations.hpp>
+
+#include <fmt/format.h>
+
+#include <string_view>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+
+enum class DumpFormat : uint8_t {
+  // Indented source text which parses back into the same tree
+  kSource,
+
+  // (binary + 1 (fn_call f x)), literals and variables are atoms
+  kSExpression,
+
+  // {"kind":"binary","op":"+","children":[...]}, one tree per line
+  kJsonLines,
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// Writes trees into one reusable memory buffer. When writing to a file
+// descriptor the buffer goes out in chunks of kChunkSize bytes, so the
+// memory used does not depend on the size of the dump. The traversal
+// uses an explicit stack, deep trees are fine.
+//
+//   Dumper dumper{STDOUT_FILENO, DumpFormat::kJsonLines};
+//   for (auto* declaration : declarations) {
+//     dumper.Dump(declaration);
+//   }
+//   dumper.Flush();
+//
+// Write errors are thrown as std::system_error from Dump or Flush.
+
+class Dumper {
+ public:
+  static constexpr size_t kChunkSize = 64 * 1024;
+
+  Dumper(int fd, DumpFormat format);
+
+  // Keeps the whole output in memory, see View
+  explicit Dumper(DumpFormat format);
+
+  Dumper(const Dumper&) = delete;
+  Dumper& operator=(const Dumper&) = delete;
+
+  // Flushes what is left, errors are lost: call Flush to see them
+  ~Dumper();
+
+  // One tree followed by '\n'
+  void Dump(TreeNode* root);
+
+  void Flush();
+
+  // Output not flushed yet, everything for an in-memory dumper
+  std::string_view View() const;
+
+ private:
+  struct Item {
+    enum class Tag : uint8_t {
+      kNode,
+      kText,
+      kToken,
+      kNewline,
+      kIndent,
+      kDedent,
+    };
+
+    Tag tag;
+    TreeNode* node = nullptr;
+    std::string_view text = {};
+    const lex::Token* token = nullptr;
+  };
+
+  class Items;
+
+  void ExpandSource(TreeNode* node, Items& items);
+  void ExpandSExpression(TreeNode* node, Items& items);
+  void ExpandJson(TreeNode* node, Items& items);
+
+  void WriteToken(const lex::Token& token);
+  void WriteJsonString(std::string_view text);
+
+ private:
+  int fd_{-1};
+  DumpFormat format_;
+
+  fmt::memory_buffer buffer_;
+
+  // Kept between dumps
+  std::vector<Item> stack_;
+  std::vector<Item> scratch_;
+
+  size_t indent_{0};
+};
+
+// Whole dump of one tree as a string
+std::string DumpToString(TreeNode* root, DumpFormat format);
+
+//////////////////////////////////////////////////////////////////////
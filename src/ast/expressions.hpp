@@ -10,25 +10,46 @@
 
 class Expression : public TreeNode {
  public:
+  static constexpr NodeKind kFirstKind = NodeKind::kComparison;
+  static constexpr NodeKind kLastKind = NodeKind::kVarAccess;
+
   virtual void Accept(Visitor*) = 0;
 
   // Later
 
   // virtual types::Type* GetType() = 0;
+
+  // Hash of the subtree, 0 until computed. A pass which rewires the
+  // children of a node resets it on the node and its ancestors, see
+  // ast/structural_hash.hpp
+  uint64_t structural_hash = 0;
+
+ protected:
+  using TreeNode::TreeNode;
 };
 
 //////////////////////////////////////////////////////////////////////
 
 // Assignable entity
 
-class LvalueExpression : public Expression {};
+class LvalueExpression : public Expression {
+ public:
+  static constexpr NodeKind kFirstKind = NodeKind::kVarAccess;
+  static constexpr NodeKind kLastKind = NodeKind::kVarAccess;
+
+ protected:
+  using Expression::Expression;
+};
 
 //////////////////////////////////////////////////////////////////////
 
 class ComparisonExpression : public Expression {
  public:
+  static constexpr NodeKind kKind = NodeKind::kComparison;
+  static constexpr bool kOwnsMemory = false;
+
   ComparisonExpression(lex::Token cmp_operator, Expression* lhs, Expression* rhs)
-      : cmp_operator(cmp_operator), lhs(lhs), rhs(rhs) {
+      : Expression{kKind}, cmp_operator(cmp_operator), lhs(lhs), rhs(rhs) {
   }
 
   virtual void Accept(Visitor* visitor) override {
@@ -50,8 +71,11 @@ class ComparisonExpression : public Expression {
 
 class BinaryExpression : public Expression {
  public:
+  static constexpr NodeKind kKind = NodeKind::kBinary;
+  static constexpr bool kOwnsMemory = false;
+
   BinaryExpression(lex::Token binary_operator, Expression* lhs, Expression* rhs)
-      : binary_operator(binary_operator), lhs(lhs), rhs(rhs) {
+      : Expression{kKind}, binary_operator(binary_operator), lhs(lhs), rhs(rhs) {
   }
 
   virtual void Accept(Visitor* visitor) override {
@@ -71,7 +95,11 @@ class BinaryExpression : public Expression {
 
 class UnaryExpression : public Expression {
  public:
-  UnaryExpression(lex::Token unary_operator, Expression* operand) : unary_operator(unary_operator), operand(operand) {
+  static constexpr NodeKind kKind = NodeKind::kUnary;
+  static constexpr bool kOwnsMemory = false;
+
+  UnaryExpression(lex::Token unary_operator, Expression* operand)
+      : Expression{kKind}, unary_operator(unary_operator), operand(operand) {
   }
 
   virtual void Accept(Visitor* visitor) override {
@@ -90,7 +118,10 @@ class UnaryExpression : public Expression {
 
 class FnCallExpression : public Expression {
  public:
-  FnCallExpression(lex::Token name, std::vector<Expression*> args) : name(name), args(args) {
+  static constexpr NodeKind kKind = NodeKind::kFnCall;
+
+  FnCallExpression(lex::Token name, std::vector<Expression*> args)
+      : Expression{kKind}, name(name), args(args) {
   }
 
   virtual void Accept(Visitor* visitor) override {
@@ -109,8 +140,10 @@ class FnCallExpression : public Expression {
 
 class BlockExpression : public Expression {
  public:
+  static constexpr NodeKind kKind = NodeKind::kBlock;
+
   BlockExpression(lex::Token open_brace, std::vector<Statement*> statements)
-      : open_brace(open_brace), statements(statements) {
+      : Expression{kKind}, open_brace(open_brace), statements(statements) {
   }
 
   virtual void Accept(Visitor* visitor) override {
@@ -129,8 +162,15 @@ class BlockExpression : public Expression {
 
 class IfExpression : public Expression {
  public:
+  static constexpr NodeKind kKind = NodeKind::kIf;
+  static constexpr bool kOwnsMemory = false;
+
   IfExpression(lex::Token if_token, Expression* condition_expr, Expression* true_expr, Expression* false_expr)
-      : if_token(if_token), condition_expr(condition_expr), true_expr(true_expr), false_expr(false_expr) {
+      : Expression{kKind},
+        if_token(if_token),
+        condition_expr(condition_expr),
+        true_expr(true_expr),
+        false_expr(false_expr) {
   }
 
   virtual void Accept(Visitor* visitor) override {
@@ -151,7 +191,10 @@ class IfExpression : public Expression {
 
 class LiteralExpression : public Expression {
  public:
-  LiteralExpression(lex::Token literal) : literal(literal) {}
+  static constexpr NodeKind kKind = NodeKind::kLiteral;
+  static constexpr bool kOwnsMemory = false;
+
+  LiteralExpression(lex::Token literal) : Expression{kKind}, literal(literal) {}
 
   virtual void Accept(Visitor* visitor) override {
     visitor->VisitLiteral(this);
@@ -168,7 +211,10 @@ class LiteralExpression : public Expression {
 
 class VarAccessExpression : public LvalueExpression {
  public:
-  VarAccessExpression(lex::Token variable) : variable(variable) {}
+  static constexpr NodeKind kKind = NodeKind::kVarAccess;
+  static constexpr bool kOwnsMemory = false;
+
+  VarAccessExpression(lex::Token variable) : LvalueExpression{kKind}, variable(variable) {}
 
   virtual void Accept(Visitor* visitor) override {
     visitor->VisitVarAccess(this);
@@ -185,8 +231,11 @@ class VarAccessExpression : public LvalueExpression {
 
 class ReturnExpression : public Expression {
  public:
+  static constexpr NodeKind kKind = NodeKind::kReturn;
+  static constexpr bool kOwnsMemory = false;
+
   ReturnExpression(lex::Token return_token, Expression* expression)
-      : return_token(return_token), expression(expression) {
+      : Expression{kKind}, return_token(return_token), expression(expression) {
   }
 
   virtual void Accept(Visitor* visitor) override {
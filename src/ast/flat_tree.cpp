@@ -0,0 +1,257 @@
+#include <ast/flat_tree.hpp>
+#include <ast/visitors/walker.hpp>
+
+////////////////////////////////////////////////////////////////////
+
+FlatTree::NodeId FlatTree::Add(NodeKind kind, const lex::Token& token, std::span<const NodeId> children) {
+  FMT_ASSERT(kinds_.size() < UINT32_MAX, "Flat tree is full\n");
+
+  auto id = static_cast<NodeId>(kinds_.size());
+
+  for ([[maybe_unused]] NodeId child : children) {
+    FMT_ASSERT(child < id, "Children must be added before the parent\n");
+  }
+
+  kinds_.push_back(kind);
+  tokens_.Append(token);
+
+  Range range{static_cast<uint32_t>(child_ids_.size()), 0};
+  child_ids_.insert(child_ids_.end(), children.begin(), children.end());
+  range.end = child_ids_.size();
+  children_.push_back(range);
+
+  return id;
+}
+
+////////////////////////////////////////////////////////////////////
+
+size_t FlatTree::Size() const {
+  return kinds_.size();
+}
+
+NodeKind FlatTree::Kind(NodeId id) const {
+  return kinds_[id];
+}
+
+lex::Token FlatTree::GetToken(NodeId id) const {
+  return tokens_.At(id);
+}
+
+std::span<const FlatTree::NodeId> FlatTree::Children(NodeId id) const {
+  Range range = children_[id];
+  return std::span{child_ids_}.subspan(range.begin, range.end - range.begin);
+}
+
+////////////////////////////////////////////////////////////////////
+
+// The token a node keeps in the flat form
+static lex::Token NodeToken(TreeNode* node) {
+  switch (node->GetKind()) {
+    /* Statements */
+    case NodeKind::kExprStatement:
+      return lex::Token{};
+    case NodeKind::kAssignment:
+      return static_cast<AssignmentStatement*>(node)->assign_token;
+
+    /* Declarations */
+    case NodeKind::kVarDecl:
+      return static_cast<VarDeclStatement*>(node)->name;
+    case NodeKind::kFunDecl:
+      return static_cast<FunDeclStatement*>(node)->name;
+
+    /* Expressions */
+    case NodeKind::kComparison:
+      return static_cast<ComparisonExpression*>(node)->cmp_operator;
+    case NodeKind::kBinary:
+      return static_cast<BinaryExpression*>(node)->binary_operator;
+    case NodeKind::kUnary:
+      return static_cast<UnaryExpression*>(node)->unary_operator;
+    case NodeKind::kFnCall:
+      return static_cast<FnCallExpression*>(node)->name;
+    case NodeKind::kBlock:
+      return static_cast<BlockExpression*>(node)->open_brace;
+    case NodeKind::kIf:
+      return static_cast<IfExpression*>(node)->if_token;
+    case NodeKind::kLiteral:
+      return static_cast<LiteralExpression*>(node)->literal;
+    case NodeKind::kVarAccess:
+      return static_cast<VarAccessExpression*>(node)->variable;
+    case NodeKind::kReturn:
+      return static_cast<ReturnExpression*>(node)->return_token;
+  }
+
+  FMT_ASSERT(false, "Unknown node kind\n");
+}
+
+namespace {
+
+// Post-order: the ids of finished children pile up on `ids_`, a node
+// takes the ones pushed since it was entered. A missing `else` is
+// simply not there, ForEachChild skips null children.
+class Flattener : public Walker<Flattener> {
+ public:
+  explicit Flattener(FlatTree& tree) : tree_{tree} {
+  }
+
+  bool Enter(TreeNode* node) {
+    marks_.push_back(ids_.size());
+
+    if (auto* fun = dyn_cast<FunDeclStatement>(node)) {
+      for (const auto& param : fun->params) {
+        ids_.push_back(tree_.Add(NodeKind::kVarAccess, param));
+      }
+    }
+
+    return true;
+  }
+
+  void Leave(TreeNode* node) {
+    size_t mark = marks_.back();
+    marks_.pop_back();
+
+    auto id = tree_.Add(node->GetKind(), NodeToken(node), std::span{ids_}.subspan(mark));
+    ids_.resize(mark);
+    ids_.push_back(id);
+  }
+
+  FlatTree::NodeId Root() const {
+    return ids_.back();
+  }
+
+ private:
+  FlatTree& tree_;
+
+  std::vector<FlatTree::NodeId> ids_;
+  std::vector<size_t> marks_;
+};
+
+}  // namespace
+
+FlatTree::NodeId FlatTree::Flatten(TreeNode* root) {
+  Flattener flattener{*this};
+  flattener.Walk(root);
+  return flattener.Root();
+}
+
+////////////////////////////////////////////////////////////////////
+
+// One node from its materialized children: all of them, or just the
+// body for a function (the parameters are tokens)
+static TreeNode* Build(const FlatTree& tree, FlatTree::NodeId id, std::span<TreeNode* const> nodes, Arena& arena) {
+  auto token = tree.GetToken(id);
+
+  auto expression = [&](size_t index) {
+    return cast<Expression>(nodes[index]);
+  };
+
+  switch (tree.Kind(id)) {
+    /* Statements */
+    case NodeKind::kExprStatement:
+      return arena.Make<ExprStatement>(expression(0));
+
+    case NodeKind::kAssignment:
+      return arena.Make<AssignmentStatement>(token, cast<LvalueExpression>(nodes[0]), expression(1));
+
+    /* Declarations */
+    case NodeKind::kVarDecl:
+      return arena.Make<VarDeclStatement>(token, expression(0));
+
+    case NodeKind::kFunDecl: {
+      auto children = tree.Children(id);
+
+      std::vector<lex::Token> params;
+      for (size_t i = 0; i + 1 < children.size(); ++i) {
+        params.push_back(tree.GetToken(children[i]));
+      }
+
+      return arena.Make<FunDeclStatement>(token, std::move(params), cast<BlockExpression>(nodes[0]));
+    }
+
+    /* Expressions */
+    case NodeKind::kComparison:
+      return arena.Make<ComparisonExpression>(token, expression(0), expression(1));
+
+    case NodeKind::kBinary:
+      return arena.Make<BinaryExpression>(token, expression(0), expression(1));
+
+    case NodeKind::kUnary:
+      return arena.Make<UnaryExpression>(token, expression(0));
+
+    case NodeKind::kFnCall: {
+      std::vector<Expression*> args;
+      for (size_t i = 0; i < nodes.size(); ++i) {
+        args.push_back(expression(i));
+      }
+      return arena.Make<FnCallExpression>(token, std::move(args));
+    }
+
+    case NodeKind::kBlock: {
+      std::vector<Statement*> statements;
+      for (auto* node : nodes) {
+        statements.push_back(cast<Statement>(node));
+      }
+      return arena.Make<BlockExpression>(token, std::move(statements));
+    }
+
+    case NodeKind::kIf: {
+      auto* false_expr = (nodes.size() > 2) ? expression(2) : nullptr;
+      return arena.Make<IfExpression>(token, expression(0), expression(1), false_expr);
+    }
+
+    case NodeKind::kLiteral:
+      return arena.Make<LiteralExpression>(token);
+
+    case NodeKind::kReturn:
+      return arena.Make<ReturnExpression>(token, expression(0));
+
+    case NodeKind::kVarAccess:
+      return arena.Make<VarAccessExpression>(token);
+  }
+
+  FMT_ASSERT(false, "Unknown node kind\n");
+}
+
+TreeNode* FlatTree::Materialize(NodeId id, Arena& arena) const {
+  struct Frame {
+    NodeId id;
+    bool leaving;
+  };
+
+  // Post-order like Flatten: a node takes the nodes its children left
+  // on `nodes` since it was entered
+  std::vector<Frame> stack{{id, false}};
+  std::vector<TreeNode*> nodes;
+  std::vector<size_t> marks;
+
+  while (!stack.empty()) {
+    auto [current, leaving] = stack.back();
+    stack.pop_back();
+
+    if (leaving) {
+      size_t mark = marks.back();
+      marks.pop_back();
+
+      auto* node = Build(*this, current, std::span{nodes}.subspan(mark), arena);
+      nodes.resize(mark);
+      nodes.push_back(node);
+      continue;
+    }
+
+    stack.push_back({current, true});
+    marks.push_back(nodes.size());
+
+    auto children = Children(current);
+
+    // Parameters are kept as tokens, only the body becomes a node
+    if (Kind(current) == NodeKind::kFunDecl) {
+      FMT_ASSERT(!children.empty(), "Function without body\n");
+      children = children.last(1);
+    }
+
+    for (auto child = children.rbegin(); child != children.rend(); ++child) {
+      stack.push_back({*child, false});
+    }
+  }
+
+  return nodes.back();
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <ast/declarations.hpp>
+#include <ast/node_kind.hpp>
+#include <ast/arena.hpp>
+
+#include <lex/token_buffer.hpp>
+
+#include <cstdint>
+#include <vector>
+#include <span>
+
+//////////////////////////////////////////////////////////////////////
+
+// Pointer-free form of the AST. A node is a 32-bit index into parallel
+// arrays: its kind, its token (stored in a TokenBuffer, so the token of
+// node `i` is token `i`), and the range of its children in one shared
+// array of node ids. Children always come before their parent.
+//
+// Children by kind:
+//
+//   kComparison, kBinary, kAssignment   lhs, rhs
+//   kUnary, kReturn, kExprStatement     operand
+//   kVarDecl                            initializer
+//   kIf                                 condition, then[, else]
+//   kFnCall                             arguments...
+//   kBlock                              statements...
+//   kFunDecl                            parameters (kVarAccess)..., body
+//   kLiteral, kVarAccess                none
+//
+// An `if` without `else` has two children.
+
+class FlatTree {
+ public:
+  using NodeId = uint32_t;
+
+  // Appends a node whose children are already in the tree
+  NodeId Add(NodeKind kind, const lex::Token& token, std::span<const NodeId> children = {});
+
+  // Converts a pointer tree, returns the id of its root. Iterative,
+  // deep trees are fine.
+  NodeId Flatten(TreeNode* root);
+
+  // Builds the pointer form of the subtree rooted at `id` in `arena`,
+  // for code which needs one. Passes over the flat tree itself use
+  // FlatWalker or FlatStaticVisitor below.
+  TreeNode* Materialize(NodeId id, Arena& arena) const;
+
+  size_t Size() const;
+
+  NodeKind Kind(NodeId id) const;
+  lex::Token GetToken(NodeId id) const;
+  std::span<const NodeId> Children(NodeId id) const;
+
+ private:
+  struct Range {
+    uint32_t begin;
+    uint32_t end;
+  };
+
+  std::vector<NodeKind> kinds_;
+  lex::TokenBuffer tokens_;
+  std::vector<Range> children_;
+
+  // Child lists of all nodes, back to back
+  std::vector<NodeId> child_ids_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// Walker (see ast/visitors/walker.hpp) over node ids: passes run on the
+// flat tree directly, nothing is converted back to pointers. Derived
+// overrides the hooks it needs:
+//
+//   // Pre-order, return false to skip the children of `id`
+//   bool Enter(const FlatTree& tree, FlatTree::NodeId id);
+//
+//   // Post-order, also called for nodes whose children were skipped
+//   void Leave(const FlatTree& tree, FlatTree::NodeId id);
+//
+// Children are visited in the order listed above, so the parameters
+// of a function are seen as kVarAccess nodes before its body.
+
+template <typename Derived>
+class FlatWalker {
+ public:
+  void Walk(const FlatTree& tree, FlatTree::NodeId root) {
+    FMT_ASSERT(root < tree.Size(), "Error: walking a node out of the tree\n");
+    FMT_ASSERT(stack_.empty(), "FlatWalker is not reentrant\n");
+
+    stack_.push_back({root, false});
+
+    while (!stack_.empty()) {
+      auto [id, leaving] = stack_.back();
+      stack_.pop_back();
+
+      if (leaving) {
+        Self().Leave(tree, id);
+        continue;
+      }
+
+      stack_.push_back({id, true});
+
+      if (!Self().Enter(tree, id)) {
+        continue;
+      }
+
+      // Pushed reversed so that the first child is popped first
+      auto children = tree.Children(id);
+      for (auto child = children.rbegin(); child != children.rend(); ++child) {
+        stack_.push_back({*child, false});
+      }
+    }
+  }
+
+  bool Enter(const FlatTree&, FlatTree::NodeId) {
+    return true;
+  }
+
+  void Leave(const FlatTree&, FlatTree::NodeId) {
+  }
+
+ private:
+  Derived& Self() {
+    return static_cast<Derived&>(*this);
+  }
+
+ private:
+  struct Frame {
+    FlatTree::NodeId id;
+    bool leaving;
+  };
+
+  std::vector<Frame> stack_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// StaticVisitor (see ast/visitors/static_visitor.hpp) over node ids:
+// Visit switches on the kind of `id` and calls the Derived::Visit*
+// with the same name as for pointer nodes, which gets the tree and the
+// id instead of a node and visits children by id:
+//
+//   class Evaluator : public FlatStaticVisitor<Evaluator, int64_t> {
+//    public:
+//     int64_t VisitBinary(const FlatTree& tree, FlatTree::NodeId id) {
+//       auto children = tree.Children(id);
+//       return Visit(tree, children[0]) + Visit(tree, children[1]);
+//     }
+//     ...
+//   };
+//
+// As with StaticVisitor, the recursion is the pass's own: deep trees
+// want FlatWalker.
+
+template <typename Derived, typename Result = void>
+class FlatStaticVisitor {
+ public:
+  Result Visit(const FlatTree& tree, FlatTree::NodeId id) {
+    FMT_ASSERT(id < tree.Size(), "Error: visiting a node out of the tree\n");
+
+    switch (tree.Kind(id)) {
+      /* Statements */
+      case NodeKind::kExprStatement:
+        return Self().VisitExprStatement(tree, id);
+      case NodeKind::kAssignment:
+        return Self().VisitAssignment(tree, id);
+
+      /* Declarations */
+      case NodeKind::kVarDecl:
+        return Self().VisitVarDecl(tree, id);
+      case NodeKind::kFunDecl:
+        return Self().VisitFunDecl(tree, id);
+
+      /* Expressions */
+      case NodeKind::kComparison:
+        return Self().VisitComparison(tree, id);
+      case NodeKind::kBinary:
+        return Self().VisitBinary(tree, id);
+      case NodeKind::kUnary:
+        return Self().VisitUnary(tree, id);
+      case NodeKind::kFnCall:
+        return Self().VisitFnCall(tree, id);
+      case NodeKind::kBlock:
+        return Self().VisitBlock(tree, id);
+      case NodeKind::kIf:
+        return Self().VisitIf(tree, id);
+      case NodeKind::kLiteral:
+        return Self().VisitLiteral(tree, id);
+      case NodeKind::kReturn:
+        return Self().VisitReturn(tree, id);
+
+      /* Lvalues */
+      case NodeKind::kVarAccess:
+        return Self().VisitVarAccess(tree, id);
+    }
+
+    FMT_ASSERT(false, "Unknown node kind\n");
+    __builtin_unreachable();
+  }
+
+ private:
+  Derived& Self() {
+    return static_cast<Derived&>(*this);
+  }
+};
+
+//////////////////////////////////////////////////////////////////////
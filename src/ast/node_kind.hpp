@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+//////////////////////////////////////////////////////////////////////
+
+// Tag of the concrete class of a node. Every abstract base covers a
+// contiguous range of kinds, so a class test is one or two integer
+// compares, see `isa` in ast/syntax_tree.hpp.
+//
+// Keep the order in sync with the ranges declared by the bases:
+//
+//   Statement          kExprStatement .. kFunDecl
+//   Declaration        kVarDecl .. kFunDecl
+//   Expression         kComparison .. kVarAccess
+//   LvalueExpression   kVarAccess .. kVarAccess
+
+enum class NodeKind : uint8_t {
+  /* Statements */
+  kExprStatement,
+  kAssignment,
+
+  /* Declarations */
+  kVarDecl,
+  kFunDecl,
+
+  /* Expressions */
+  kComparison,
+  kBinary,
+  kUnary,
+  kFnCall,
+  kBlock,
+  kIf,
+  kLiteral,
+  kReturn,
+
+  /* Lvalues */
+  kVarAccess,
+};
+
+//////////////////////////////////////////////////////////////////////
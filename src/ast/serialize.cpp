@@ -0,0 +1,548 @@
+#include <ast/serialize.hpp>
+#include <ast/visitors/walker.hpp>
+
+#include <lex/mapped_file.hpp>
+#include <lex/source_map.hpp>
+
+#include <unordered_map>
+#include <system_error>
+#include <optional>
+#include <fstream>
+#include <cstring>
+#include <array>
+#include <bit>
+
+static_assert(std::endian::native == std::endian::little, "The AST format is little-endian");
+
+////////////////////////////////////////////////////////////////////
+
+namespace {
+
+struct Header {
+  std::array<char, 4> magic;
+  uint32_t version;
+
+  uint32_t nodes;
+  uint32_t numbers;
+  uint32_t files;
+  uint32_t strings;
+  uint32_t string_bytes;
+  uint32_t reserved = 0;
+};
+
+constexpr std::array<char, 4> kMagic = {'E', 'A', 'S', 'T'};
+
+struct StoredLocation {
+  uint32_t offset;
+  uint32_t file;
+};
+
+// Byte offsets of the sections, in file order
+struct Layout {
+  size_t numbers;
+  size_t locations;
+  size_t counts;
+  size_t payloads;
+  size_t files;
+  size_t string_offsets;
+  size_t kinds;
+  size_t types;
+  size_t string_bytes;
+  size_t end;
+};
+
+Layout ComputeLayout(const Header& header) {
+  Layout layout{};
+  size_t offset = sizeof(Header);
+
+  auto section = [&offset](size_t& at, size_t bytes) {
+    at = offset;
+    offset += bytes;
+  };
+
+  section(layout.numbers, size_t{header.numbers} * sizeof(uint64_t));
+  section(layout.locations, size_t{header.nodes} * sizeof(StoredLocation));
+  section(layout.counts, size_t{header.nodes} * sizeof(uint32_t));
+  section(layout.payloads, size_t{header.nodes} * sizeof(uint32_t));
+  section(layout.files, size_t{header.files} * sizeof(uint32_t));
+  section(layout.string_offsets, (size_t{header.strings} + 1) * sizeof(uint32_t));
+  section(layout.kinds, header.nodes);
+  section(layout.types, header.nodes);
+  section(layout.string_bytes, header.string_bytes);
+  layout.end = offset;
+
+  return layout;
+}
+
+////////////////////////////////////////////////////////////////////
+
+// Token of the node itself, the one the flat form stores
+lex::Token NodeToken(TreeNode* node) {
+  switch (node->GetKind()) {
+    case NodeKind::kExprStatement:
+      return lex::Token{};
+    case NodeKind::kAssignment:
+      return static_cast<AssignmentStatement*>(node)->assign_token;
+    case NodeKind::kVarDecl:
+      return static_cast<VarDeclStatement*>(node)->name;
+    case NodeKind::kFunDecl:
+      return static_cast<FunDeclStatement*>(node)->name;
+    case NodeKind::kComparison:
+      return static_cast<ComparisonExpression*>(node)->cmp_operator;
+    case NodeKind::kBinary:
+      return static_cast<BinaryExpression*>(node)->binary_operator;
+    case NodeKind::kUnary:
+      return static_cast<UnaryExpression*>(node)->unary_operator;
+    case NodeKind::kFnCall:
+      return static_cast<FnCallExpression*>(node)->name;
+    case NodeKind::kBlock:
+      return static_cast<BlockExpression*>(node)->open_brace;
+    case NodeKind::kIf:
+      return static_cast<IfExpression*>(node)->if_token;
+    case NodeKind::kLiteral:
+      return static_cast<LiteralExpression*>(node)->literal;
+    case NodeKind::kReturn:
+      return static_cast<ReturnExpression*>(node)->return_token;
+    case NodeKind::kVarAccess:
+      return static_cast<VarAccessExpression*>(node)->variable;
+  }
+
+  FMT_ASSERT(false, "Unknown node kind\n");
+}
+
+bool HasSymbol(lex::TokenType type) {
+  return type == lex::TokenType::kIdentifier || type == lex::TokenType::kString;
+}
+
+// Whether a node of `kind` can carry a token of `type`. Nodes whose
+// token is only a location (blocks, `if`, `return`, ...) take any.
+bool TokenFits(NodeKind kind, lex::TokenType type) {
+  using lex::TokenType;
+
+  switch (kind) {
+    case NodeKind::kVarAccess:
+    case NodeKind::kFnCall:
+    case NodeKind::kVarDecl:
+    case NodeKind::kFunDecl:
+      return type == TokenType::kIdentifier;
+
+    case NodeKind::kBinary:
+      return type == TokenType::kPlus || type == TokenType::kMinus ||  //
+             type == TokenType::kStar || type == TokenType::kDiv;
+
+    case NodeKind::kComparison:
+      return type == TokenType::kEquals || type == TokenType::kNotEq ||  //
+             type == TokenType::kLess || type == TokenType::kGreater;
+
+    case NodeKind::kUnary:
+      return type == TokenType::kMinus || type == TokenType::kNot;
+
+    case NodeKind::kLiteral:
+      return type == TokenType::kNumber || type == TokenType::kString ||  //
+             type == TokenType::kTrue || type == TokenType::kFalse;
+
+    default:
+      return type != TokenType::kError;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+
+// Post-order walk appending nodes to the sections
+
+class Encoder : public Walker<Encoder> {
+ public:
+  bool Enter(TreeNode* node) {
+    // Parameters go before the body, they are the first children
+    if (auto* fun = dyn_cast<FunDeclStatement>(node)) {
+      for (const auto& param : fun->params) {
+        Emit(NodeKind::kVarAccess, param, 0);
+      }
+    }
+    return true;
+  }
+
+  void Leave(TreeNode* node) {
+    uint32_t count = 0;
+    ForEachChild(node, [&count](TreeNode*) {
+      ++count;
+    });
+
+    if (auto* fun = dyn_cast<FunDeclStatement>(node)) {
+      count += fun->params.size();
+    }
+
+    Emit(node->GetKind(), NodeToken(node), count);
+  }
+
+  std::string Finish() &&;
+
+ private:
+  void Emit(NodeKind kind, const lex::Token& token, uint32_t count) {
+    FMT_ASSERT(kinds_.size() < UINT32_MAX, "AST is too large to encode\n");
+
+    kinds_.push_back(static_cast<uint8_t>(kind));
+    types_.push_back(static_cast<uint8_t>(token.type));
+    counts_.push_back(count);
+
+    if (token.type == lex::TokenType::kNumber) {
+      payloads_.push_back(numbers_.size());
+      numbers_.push_back(token.value.number);
+    } else if (HasSymbol(token.type)) {
+      payloads_.push_back(String(token.value.identifier.View(), symbols_, token.value.identifier.id));
+    } else {
+      payloads_.push_back(0);
+    }
+
+    locations_.push_back({token.location.offset, File(token.location.file_id)});
+  }
+
+  // Index into the string table, each distinct string is stored once
+  uint32_t String(std::string_view text, std::unordered_map<uint32_t, uint32_t>& seen, uint32_t key) {
+    auto [it, inserted] = seen.try_emplace(key, string_offsets_.size() - 1);
+    if (inserted) {
+      string_bytes_.append(text);
+      string_offsets_.push_back(string_bytes_.size());
+    }
+    return it->second;
+  }
+
+  uint32_t File(uint32_t file_id) {
+    if (file_id == 0) {
+      return 0;
+    }
+
+    auto [it, inserted] = file_indices_.try_emplace(file_id, files_.size() + 1);
+    if (inserted) {
+      files_.push_back(String(lex::SourceMap::Session().FileName(file_id), file_names_, file_id));
+    }
+    return it->second;
+  }
+
+ private:
+  std::vector<uint8_t> kinds_;
+  std::vector<uint8_t> types_;
+  std::vector<uint32_t> counts_;
+  std::vector<uint32_t> payloads_;
+  std::vector<uint64_t> numbers_;
+  std::vector<StoredLocation> locations_;
+  std::vector<uint32_t> files_;
+  std::vector<uint32_t> string_offsets_{0};
+  std::string string_bytes_;
+
+  // Symbol id -> string index, session file id -> string / file index
+  std::unordered_map<uint32_t, uint32_t> symbols_;
+  std::unordered_map<uint32_t, uint32_t> file_names_;
+  std::unordered_map<uint32_t, uint32_t> file_indices_;
+};
+
+std::string Encoder::Finish() && {
+  Header header{
+      .magic = kMagic,
+      .version = kAstFormatVersion,
+      .nodes = static_cast<uint32_t>(kinds_.size()),
+      .numbers = static_cast<uint32_t>(numbers_.size()),
+      .files = static_cast<uint32_t>(files_.size()),
+      .strings = static_cast<uint32_t>(string_offsets_.size() - 1),
+      .string_bytes = static_cast<uint32_t>(string_bytes_.size()),
+  };
+
+  auto layout = ComputeLayout(header);
+
+  std::string bytes(layout.end, '\0');
+
+  auto put = [&bytes](size_t at, const auto& section) {
+    if (std::size(section) == 0) {
+      return;
+    }
+    std::memcpy(bytes.data() + at, std::data(section), std::size(section) * sizeof(*std::data(section)));
+  };
+
+  std::memcpy(bytes.data(), &header, sizeof(header));
+  put(layout.numbers, numbers_);
+  put(layout.locations, locations_);
+  put(layout.counts, counts_);
+  put(layout.payloads, payloads_);
+  put(layout.files, files_);
+  put(layout.string_offsets, string_offsets_);
+  put(layout.kinds, kinds_);
+  put(layout.types, types_);
+  put(layout.string_bytes, string_bytes_);
+
+  return bytes;
+}
+
+////////////////////////////////////////////////////////////////////
+
+template <typename T>
+std::span<const T> Section(std::string_view bytes, size_t at, size_t count) {
+  return {reinterpret_cast<const T*>(bytes.data() + at), count};
+}
+
+class Decoder {
+ public:
+  Decoder(std::string_view bytes, Arena& arena, std::optional<uint32_t> file_id)
+      : bytes_{bytes}, arena_{arena}, file_id_{file_id} {
+    if (bytes.size() < sizeof(Header)) {
+      throw AstReadError{"AST file is truncated"};
+    }
+
+    FMT_ASSERT(reinterpret_cast<uintptr_t>(bytes.data()) % alignof(uint64_t) == 0, "Unaligned AST bytes\n");
+
+    std::memcpy(&header_, bytes.data(), sizeof(header_));
+
+    if (header_.magic != kMagic) {
+      throw AstReadError{"Not an AST file"};
+    }
+
+    if (header_.version != kAstFormatVersion) {
+      throw AstReadError{fmt::format("AST format version {}, expected {}", header_.version, kAstFormatVersion)};
+    }
+
+    layout_ = ComputeLayout(header_);
+    if (layout_.end > bytes.size()) {
+      throw AstReadError{"AST file is truncated"};
+    }
+
+    string_offsets_ = Section<uint32_t>(bytes, layout_.string_offsets, header_.strings + 1);
+    if (string_offsets_.back() > header_.string_bytes) {
+      throw AstReadError{"AST string table is corrupt"};
+    }
+
+    symbols_.assign(header_.strings, kNotInterned);
+  }
+
+  std::vector<TreeNode*> Decode();
+
+ private:
+  static constexpr lex::SymbolId kNotInterned = UINT32_MAX;
+
+  std::string_view String(uint64_t index) {
+    if (index >= header_.strings || string_offsets_[index] > string_offsets_[index + 1]) {
+      throw AstReadError{"AST string index is corrupt"};
+    }
+
+    return bytes_.substr(layout_.string_bytes + string_offsets_[index],  //
+                         string_offsets_[index + 1] - string_offsets_[index]);
+  }
+
+  lex::Symbol Symbol(uint64_t index) {
+    auto text = String(index);
+
+    if (symbols_[index] == kNotInterned) {
+      symbols_[index] = lex::Interner::Session().Intern(text);
+    }
+    return lex::Symbol::FromId(symbols_[index]);
+  }
+
+  TreeNode* Build(NodeKind kind, const lex::Token& token, std::span<TreeNode* const> children);
+
+  template <typename T>
+  T* Child(std::span<TreeNode* const> children, size_t index) {
+    auto* node = dyn_cast<T>(children[index]);
+    if (node == nullptr) {
+      throw AstReadError{"AST node has a child of the wrong kind"};
+    }
+    return node;
+  }
+
+ private:
+  std::string_view bytes_;
+  Arena& arena_;
+
+  // Replaces every recorded file if set
+  std::optional<uint32_t> file_id_;
+
+  Header header_{};
+  Layout layout_{};
+
+  std::span<const uint32_t> string_offsets_;
+
+  // String index -> session symbol, interned on first use
+  std::vector<lex::SymbolId> symbols_;
+};
+
+std::vector<TreeNode*> Decoder::Decode() {
+  auto numbers = Section<uint64_t>(bytes_, layout_.numbers, header_.numbers);
+  auto locations = Section<StoredLocation>(bytes_, layout_.locations, header_.nodes);
+  auto counts = Section<uint32_t>(bytes_, layout_.counts, header_.nodes);
+  auto payloads = Section<uint32_t>(bytes_, layout_.payloads, header_.nodes);
+  auto files = Section<uint32_t>(bytes_, layout_.files, header_.files);
+  auto kinds = Section<uint8_t>(bytes_, layout_.kinds, header_.nodes);
+  auto types = Section<uint8_t>(bytes_, layout_.types, header_.nodes);
+
+  // File index + 1 -> session file id, 0 stays 0
+  std::vector<uint32_t> file_ids{0};
+  for (uint32_t name : files) {
+    file_ids.push_back(file_id_ ? *file_id_ : lex::SourceMap::Session().AddFile(std::string{String(name)}));
+  }
+
+  // Trees built so far, children of the next node are on top
+  std::vector<TreeNode*> trees;
+
+  for (uint32_t id = 0; id < header_.nodes; ++id) {
+    if (counts[id] > trees.size()) {
+      throw AstReadError{"AST node has more children than trees before it"};
+    }
+
+    if (types[id] > static_cast<uint8_t>(lex::TokenType::kEOF)) {
+      throw AstReadError{"AST token type is corrupt"};
+    }
+
+    lex::Token token{};
+    token.type = static_cast<lex::TokenType>(types[id]);
+
+    if (token.type == lex::TokenType::kNumber) {
+      if (payloads[id] >= header_.numbers) {
+        throw AstReadError{"AST number index is corrupt"};
+      }
+      token.value.number = numbers[payloads[id]];
+    } else if (HasSymbol(token.type)) {
+      token.value.identifier = Symbol(payloads[id]);
+    }
+
+    if (locations[id].file >= file_ids.size()) {
+      throw AstReadError{"AST file index is corrupt"};
+    }
+    token.location = {locations[id].offset, file_ids[locations[id].file]};
+
+    if (kinds[id] > static_cast<uint8_t>(NodeKind::kVarAccess)) {
+      throw AstReadError{"AST node kind is corrupt"};
+    }
+
+    std::span children{trees.end() - counts[id], trees.end()};
+    auto* node = Build(static_cast<NodeKind>(kinds[id]), token, children);
+
+    trees.resize(trees.size() - counts[id]);
+    trees.push_back(node);
+  }
+
+  return trees;
+}
+
+TreeNode* Decoder::Build(NodeKind kind, const lex::Token& token, std::span<TreeNode* const> children) {
+  auto expect = [&children](size_t min, size_t max) {
+    if (children.size() < min || children.size() > max) {
+      throw AstReadError{"AST node has a wrong number of children"};
+    }
+  };
+
+  auto expression = [&](size_t index) {
+    return Child<Expression>(children, index);
+  };
+
+  if (!TokenFits(kind, token.type)) {
+    throw AstReadError{"AST node token does not fit its kind"};
+  }
+
+  switch (kind) {
+    /* Statements */
+    case NodeKind::kExprStatement:
+      expect(1, 1);
+      return arena_.Make<ExprStatement>(expression(0));
+
+    case NodeKind::kAssignment:
+      expect(2, 2);
+      return arena_.Make<AssignmentStatement>(token, Child<LvalueExpression>(children, 0), expression(1));
+
+    /* Declarations */
+    case NodeKind::kVarDecl:
+      expect(1, 1);
+      return arena_.Make<VarDeclStatement>(token, expression(0));
+
+    case NodeKind::kFunDecl: {
+      expect(1, SIZE_MAX);
+
+      std::vector<lex::Token> params;
+      for (size_t i = 0; i + 1 < children.size(); ++i) {
+        params.push_back(Child<VarAccessExpression>(children, i)->variable);
+      }
+
+      auto* body = Child<BlockExpression>(children, children.size() - 1);
+      return arena_.Make<FunDeclStatement>(token, std::move(params), body);
+    }
+
+    /* Expressions */
+    case NodeKind::kComparison:
+      expect(2, 2);
+      return arena_.Make<ComparisonExpression>(token, expression(0), expression(1));
+
+    case NodeKind::kBinary:
+      expect(2, 2);
+      return arena_.Make<BinaryExpression>(token, expression(0), expression(1));
+
+    case NodeKind::kUnary:
+      expect(1, 1);
+      return arena_.Make<UnaryExpression>(token, expression(0));
+
+    case NodeKind::kFnCall: {
+      std::vector<Expression*> args;
+      for (size_t i = 0; i < children.size(); ++i) {
+        args.push_back(expression(i));
+      }
+      return arena_.Make<FnCallExpression>(token, std::move(args));
+    }
+
+    case NodeKind::kBlock: {
+      std::vector<Statement*> statements;
+      for (size_t i = 0; i < children.size(); ++i) {
+        statements.push_back(Child<Statement>(children, i));
+      }
+      return arena_.Make<BlockExpression>(token, std::move(statements));
+    }
+
+    case NodeKind::kIf:
+      expect(2, 3);
+      return arena_.Make<IfExpression>(token, expression(0), expression(1),
+                                       children.size() == 3 ? expression(2) : nullptr);
+
+    case NodeKind::kLiteral:
+      expect(0, 0);
+      return arena_.Make<LiteralExpression>(token);
+
+    case NodeKind::kReturn:
+      expect(1, 1);
+      return arena_.Make<ReturnExpression>(token, expression(0));
+
+    case NodeKind::kVarAccess:
+      expect(0, 0);
+      return arena_.Make<VarAccessExpression>(token);
+  }
+
+  throw AstReadError{"AST node kind is corrupt"};
+}
+
+}  // namespace
+
+////////////////////////////////////////////////////////////////////
+
+std::string EncodeAst(std::span<TreeNode* const> roots) {
+  Encoder encoder;
+  for (auto* root : roots) {
+    encoder.Walk(root);
+  }
+  return std::move(encoder).Finish();
+}
+
+void WriteAst(const std::filesystem::path& path, std::span<TreeNode* const> roots) {
+  auto bytes = EncodeAst(roots);
+
+  std::ofstream file{path, std::ios::binary | std::ios::trunc};
+  file.write(bytes.data(), bytes.size());
+  if (!file.flush()) {
+    throw std::system_error(errno, std::generic_category(), path.string());
+  }
+}
+
+std::vector<TreeNode*> DecodeAst(std::string_view bytes, Arena& arena) {
+  return Decoder{bytes, arena, std::nullopt}.Decode();
+}
+
+std::vector<TreeNode*> DecodeAst(std::string_view bytes, Arena& arena, uint32_t file_id) {
+  return Decoder{bytes, arena, file_id}.Decode();
+}
+
+std::vector<TreeNode*> ReadAst(const std::filesystem::path& path, Arena& arena) {
+  lex::MappedFile file{path};
+  return DecodeAst(file.View(), arena);
+}
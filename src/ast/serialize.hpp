@@ -0,0 +1,70 @@
+#pragma once
+
+#include <ast/declarations.hpp>
+#include <ast/arena.hpp>
+
+#include <filesystem>
+#include <string_view>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <span>
+
+//////////////////////////////////////////////////////////////////////
+
+// Binary form of whole trees, read back without lexing or parsing.
+//
+// The file is a fixed header followed by structure-of-arrays sections,
+// each aligned for its element type, so the reader uses them in place
+// in a read-only mapping:
+//
+//   header      magic "EAST", version, section sizes
+//   numbers     u64 values of the number literals
+//   locations   {offset, file} per node, file 0 is "no file"
+//   counts      u32 number of children per node
+//   payloads    u32 per node: index into numbers or into strings
+//   files       u32 string index of the file names
+//   strings     u32 offsets + 1, then the bytes
+//   kinds       u8 NodeKind per node
+//   types       u8 TokenType of the node token per node
+//
+// Nodes are stored in post-order, so the children of a node are the
+// last `count` trees before it and no child ids are needed; what is
+// left at the end are the roots. Parameters of a function are
+// kVarAccess nodes preceding its body, an `if` without `else` has two
+// children. Strings are interned again on load, file ids registered
+// again in the SourceMap (without line indices). Little-endian only.
+
+inline constexpr uint32_t kAstFormatVersion = 1;
+
+struct AstReadError : std::exception {
+  std::string message;
+
+  explicit AstReadError(std::string message) : message{std::move(message)} {
+  }
+
+  const char* what() const noexcept override {
+    return message.c_str();
+  }
+};
+
+//////////////////////////////////////////////////////////////////////
+
+std::string EncodeAst(std::span<TreeNode* const> roots);
+
+void WriteAst(const std::filesystem::path& path, std::span<TreeNode* const> roots);
+
+// Nodes are created in `arena`, returns the roots in the original order.
+// Throws AstReadError for a truncated, corrupt or foreign file.
+//
+// `bytes` must be 8-byte aligned (a mapping or a std::string are)
+std::vector<TreeNode*> DecodeAst(std::string_view bytes, Arena& arena);
+
+// Same, but all locations are put into the session file `file_id`
+// instead of the files recorded: the trees of one source file read back
+// for a file with the same contents
+std::vector<TreeNode*> DecodeAst(std::string_view bytes, Arena& arena, uint32_t file_id);
+
+std::vector<TreeNode*> ReadAst(const std::filesystem::path& path, Arena& arena);
+
+//////////////////////////////////////////////////////////////////////
@@ -11,13 +11,21 @@
 
 class Statement : public TreeNode {
  public:
+  static constexpr NodeKind kFirstKind = NodeKind::kExprStatement;
+  static constexpr NodeKind kLastKind = NodeKind::kFunDecl;
+
+ protected:
+  using TreeNode::TreeNode;
 };
 
 //////////////////////////////////////////////////////////////////////
 
 class ExprStatement : public Statement {
  public:
-  ExprStatement(Expression* expr) : expr{expr} {
+  static constexpr NodeKind kKind = NodeKind::kExprStatement;
+  static constexpr bool kOwnsMemory = false;
+
+  ExprStatement(Expression* expr) : Statement{kKind}, expr{expr} {
   }
 
   virtual void Accept(Visitor* visitor) override {
@@ -35,8 +43,11 @@ class ExprStatement : public Statement {
 
 class AssignmentStatement : public Statement {
  public:
-  AssignmentStatement(lex::Token assign_token, UnaryExpression* lhs, Expression* rhs)
-      : assign_token(assign_token), lhs(lhs), rhs(rhs) {
+  static constexpr NodeKind kKind = NodeKind::kAssignment;
+  static constexpr bool kOwnsMemory = false;
+
+  AssignmentStatement(lex::Token assign_token, LvalueExpression* lhs, Expression* rhs)
+      : Statement{kKind}, assign_token(assign_token), lhs(lhs), rhs(rhs) {
   }
 
   virtual void Accept(Visitor* visitor) override {
@@ -48,7 +59,7 @@ class AssignmentStatement : public Statement {
   }
 
   lex::Token assign_token;
-  UnaryExpression* lhs;
+  LvalueExpression* lhs;
   Expression* rhs;
 };
 
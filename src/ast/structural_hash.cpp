@@ -0,0 +1,237 @@
+#include <ast/structural_hash.hpp>
+#include <ast/visitors/walker.hpp>
+
+#include <util/hash.hpp>
+
+#include <vector>
+
+////////////////////////////////////////////////////////////////////
+
+// The part of the node's own token which matters for equality
+
+static const lex::Token* SignificantToken(TreeNode* node) {
+  switch (node->GetKind()) {
+    case NodeKind::kVarDecl:
+      return &static_cast<VarDeclStatement*>(node)->name;
+    case NodeKind::kFunDecl:
+      return &static_cast<FunDeclStatement*>(node)->name;
+    case NodeKind::kComparison:
+      return &static_cast<ComparisonExpression*>(node)->cmp_operator;
+    case NodeKind::kBinary:
+      return &static_cast<BinaryExpression*>(node)->binary_operator;
+    case NodeKind::kUnary:
+      return &static_cast<UnaryExpression*>(node)->unary_operator;
+    case NodeKind::kFnCall:
+      return &static_cast<FnCallExpression*>(node)->name;
+    case NodeKind::kLiteral:
+      return &static_cast<LiteralExpression*>(node)->literal;
+    case NodeKind::kVarAccess:
+      return &static_cast<VarAccessExpression*>(node)->variable;
+    default:
+      return nullptr;
+  }
+}
+
+static uint64_t TokenKey(const lex::Token& token) {
+  uint64_t payload = 0;
+
+  switch (token.type) {
+    case lex::TokenType::kNumber:
+      payload = token.value.number;
+      break;
+
+    case lex::TokenType::kString:
+    case lex::TokenType::kIdentifier:
+      payload = token.value.identifier.id;
+      break;
+
+    default:
+      break;
+  }
+
+  return util::HashCombine(static_cast<uint64_t>(token.type), payload);
+}
+
+// Everything of the node apart from its children
+static uint64_t ShallowKey(TreeNode* node) {
+  uint64_t key = static_cast<uint64_t>(node->GetKind());
+
+  if (auto* token = SignificantToken(node)) {
+    key = util::HashCombine(key, TokenKey(*token));
+  }
+
+  if (auto* fun = dyn_cast<FunDeclStatement>(node)) {
+    for (const auto& param : fun->params) {
+      key = util::HashCombine(key, TokenKey(param));
+    }
+  }
+
+  return key;
+}
+
+static bool ShallowEqual(TreeNode* lhs, TreeNode* rhs) {
+  if (lhs->GetKind() != rhs->GetKind()) {
+    return false;
+  }
+
+  auto* lhs_token = SignificantToken(lhs);
+  auto* rhs_token = SignificantToken(rhs);
+  if (lhs_token != nullptr && TokenKey(*lhs_token) != TokenKey(*rhs_token)) {
+    return false;
+  }
+
+  if (auto* lhs_fun = dyn_cast<FunDeclStatement>(lhs)) {
+    auto* rhs_fun = static_cast<FunDeclStatement*>(rhs);
+    if (lhs_fun->params.size() != rhs_fun->params.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < lhs_fun->params.size(); ++i) {
+      if (TokenKey(lhs_fun->params[i]) != TokenKey(rhs_fun->params[i])) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+static std::vector<TreeNode*> Children(TreeNode* node) {
+  std::vector<TreeNode*> children;
+  ForEachChild(node, [&children](TreeNode* child) {
+    children.push_back(child);
+  });
+  return children;
+}
+
+////////////////////////////////////////////////////////////////////
+
+// Hash of a node whose expression children are hashed already.
+// Statements (the children of blocks) are not cached, they are one
+// level deep: their own children are expressions.
+
+static uint64_t NodeHash(TreeNode* node) {
+  uint64_t hash = ShallowKey(node);
+  size_t count = 0;
+
+  ForEachChild(node, [&](TreeNode* child) {
+    auto* expr = dyn_cast<Expression>(child);
+    hash = util::HashCombine(hash, expr ? expr->structural_hash : NodeHash(child));
+    ++count;
+  });
+
+  // `if` without `else` differs from one whose `else` hashes to this
+  hash = util::HashCombine(hash, count);
+
+  // 0 means "not computed"
+  return hash != 0 ? hash : 1;
+}
+
+namespace {
+
+class Hasher : public Walker<Hasher> {
+ public:
+  bool Enter(TreeNode* node) {
+    // A hashed expression has hashed children
+    auto* expr = dyn_cast<Expression>(node);
+    return expr == nullptr || expr->structural_hash == 0;
+  }
+
+  void Leave(TreeNode* node) {
+    if (auto* expr = dyn_cast<Expression>(node); expr && expr->structural_hash == 0) {
+      expr->structural_hash = NodeHash(node);
+    }
+  }
+};
+
+}  // namespace
+
+uint64_t StructuralHash(Expression* expr) {
+  FMT_ASSERT(expr, "Error: hashing null expression\n");
+
+  if (expr->structural_hash == 0) {
+    Hasher{}.Walk(expr);
+  }
+  return expr->structural_hash;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool StructurallyEqual(Expression* lhs, Expression* rhs) {
+  if (StructuralHash(lhs) != StructuralHash(rhs)) {
+    return false;
+  }
+
+  std::vector<std::pair<TreeNode*, TreeNode*>> pending{{lhs, rhs}};
+
+  while (!pending.empty()) {
+    auto [a, b] = pending.back();
+    pending.pop_back();
+
+    if (a == b) {
+      continue;
+    }
+
+    if (!ShallowEqual(a, b)) {
+      return false;
+    }
+
+    auto a_children = Children(a);
+    auto b_children = Children(b);
+    if (a_children.size() != b_children.size()) {
+      return false;
+    }
+
+    for (size_t i = 0; i < a_children.size(); ++i) {
+      pending.emplace_back(a_children[i], b_children[i]);
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool HashConser::IsShareable(Expression* candidate) const {
+  switch (candidate->GetKind()) {
+    case NodeKind::kLiteral:
+    case NodeKind::kVarAccess:
+      return true;
+
+    case NodeKind::kComparison:
+    case NodeKind::kBinary:
+    case NodeKind::kUnary: {
+      bool pure = true;
+      ForEachChild(candidate, [&](TreeNode* child) {
+        pure = pure && shared_.contains(static_cast<Expression*>(child));
+      });
+      return pure;
+    }
+
+    default:
+      return false;
+  }
+}
+
+Expression* HashConser::Find(Expression* candidate, uint64_t hash) const {
+  auto [begin, end] = table_.equal_range(hash);
+
+  for (auto it = begin; it != end; ++it) {
+    Expression* existing = it->second;
+
+    if (!ShallowEqual(candidate, existing)) {
+      continue;
+    }
+
+    // Children are shared, so equal children are the same nodes
+    if (Children(candidate) == Children(existing)) {
+      return existing;
+    }
+  }
+
+  return nullptr;
+}
+
+void HashConser::Insert(Expression* node, uint64_t hash) {
+  table_.emplace(hash, node);
+  shared_.insert(node);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <ast/declarations.hpp>
+#include <ast/arena.hpp>
+
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
+#include <utility>
+
+//////////////////////////////////////////////////////////////////////
+
+// Structural hash: node kinds, operators, names and literal values of a
+// subtree, but not its locations. Structurally equal subtrees hash the
+// same, so passes (CSE, memoized type checking, code caches) can key
+// on 64 bits instead of walking trees.
+//
+// Computed bottom-up and cached in Expression::structural_hash: the
+// first call walks the uncached part of the subtree (iteratively),
+// later calls cost a load.
+
+uint64_t StructuralHash(Expression* expr);
+
+// Full comparison, for when hashes match. Iterative as well.
+bool StructurallyEqual(Expression* lhs, Expression* rhs);
+
+//////////////////////////////////////////////////////////////////////
+
+// Hash-consing: keeps one node per distinct pure subtree, structurally
+// equal ones are the same pointer. Pure are literals, variable reads
+// and operators over pure operands; calls, blocks, `if` and `return`
+// are never shared.
+//
+// Sharing turns the tree into a DAG: use it only for passes which
+// treat expressions as values and do not annotate nodes in place.
+//
+// Since the children of a candidate are already shared, equality of
+// candidates is one level deep: kind, token and child pointers.
+
+class HashConser {
+ public:
+  // The shared node equal to `candidate`, or a new node in `arena` if
+  // it is the first of its kind (or not pure)
+  template <typename Node>
+  Node* Share(Node&& candidate, Arena& arena) {
+    if (!IsShareable(&candidate)) {
+      return arena.Make<Node>(std::move(candidate));
+    }
+
+    uint64_t hash = StructuralHash(&candidate);
+
+    if (auto* existing = Find(&candidate, hash)) {
+      ++hits_;
+      return static_cast<Node*>(existing);
+    }
+
+    auto* node = arena.Make<Node>(std::move(candidate));
+    Insert(node, hash);
+    return node;
+  }
+
+  // Nodes handed out again instead of being created
+  size_t Hits() const {
+    return hits_;
+  }
+
+  size_t Size() const {
+    return shared_.size();
+  }
+
+ private:
+  bool IsShareable(Expression* candidate) const;
+
+  Expression* Find(Expression* candidate, uint64_t hash) const;
+
+  void Insert(Expression* node, uint64_t hash);
+
+ private:
+  std::unordered_multimap<uint64_t, Expression*> table_;
+  std::unordered_set<Expression*> shared_;
+
+  size_t hits_{0};
+};
+
+//////////////////////////////////////////////////////////////////////
@@ -1,23 +1,77 @@
 #pragma once
 
 #include <ast/visitors/visitor.hpp>
+#include <ast/node_kind.hpp>
 
 #include <lex/location.hpp>
 
+#include <fmt/core.h>
+
 //////////////////////////////////////////////////////////////////////
 
 class TreeNode {
  public:
+  // The Arena runs the destructors of nodes, unless a node states that
+  // its members own no memory (tokens and child pointers only): then it
+  // is just dropped. New nodes are destroyed until they opt out.
+  static constexpr bool kOwnsMemory = true;
+
   virtual void Accept(Visitor* visitor) = 0;
 
   virtual lex::Location GetLocation() = 0;
 
   virtual ~TreeNode() = default;
 
+  NodeKind GetKind() const {
+    return kind_;
+  }
+
+  // nullptr if the node is not a T
   template <typename T>
-  T* as() {
-    return dynamic_cast<T*>(this);
+  T* as();
+
+ protected:
+  explicit TreeNode(NodeKind kind) : kind_{kind} {
   }
+
+ private:
+  NodeKind kind_;
 };
 
 //////////////////////////////////////////////////////////////////////
+
+// LLVM-style casts driven by NodeKind instead of RTTI. Concrete nodes
+// declare their `kKind`, abstract bases the range `kFirstKind` ..
+// `kLastKind` of their descendants.
+//
+//   if (auto* var = dyn_cast<VarAccessExpression>(expr)) { ... }
+
+template <typename T>
+bool isa(const TreeNode* node) {
+  NodeKind kind = node->GetKind();
+
+  if constexpr (requires { T::kKind; }) {
+    return kind == T::kKind;
+  } else {
+    return T::kFirstKind <= kind && kind <= T::kLastKind;
+  }
+}
+
+// The node must be a T
+template <typename T>
+T* cast(TreeNode* node) {
+  FMT_ASSERT(isa<T>(node), "Invalid node cast\n");
+  return static_cast<T*>(node);
+}
+
+template <typename T>
+T* dyn_cast(TreeNode* node) {
+  return (node != nullptr && isa<T>(node)) ? static_cast<T*>(node) : nullptr;
+}
+
+template <typename T>
+T* TreeNode::as() {
+  return dyn_cast<T>(this);
+}
+
+//////////////////////////////////////////////////////////////////////
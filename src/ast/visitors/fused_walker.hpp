@@ -0,0 +1,136 @@
+#pragma once
+
+#include <ast/visitors/walker.hpp>
+
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+#include <array>
+#include <tuple>
+
+//////////////////////////////////////////////////////////////////////
+
+// Runs several passes in one traversal: every node is loaded once and
+// handed to each pass in turn, so N analyses cost about one walk of
+// memory traffic instead of N.
+//
+// A pass is any class with (either of) the Walker hooks
+//
+//   bool Enter(TreeNode* node);  // false skips the children for this pass only
+//   void Leave(TreeNode* node);
+//
+// and may list the passes whose results it reads on the same node:
+//
+//   struct TypeCheck {
+//     using Requires = std::tuple<Resolve>;
+//     ...
+//   };
+//
+//   Resolve resolve;
+//   TypeCheck check;
+//   FusedWalker{resolve, check}.Walk(root);
+//
+// Hooks run in the order the passes are given, for Enter and Leave
+// alike; a pass listed before one of its Requires does not compile.
+// Requires missing from the list are assumed to have run before.
+
+namespace detail {
+
+template <typename T, typename... List>
+constexpr size_t IndexOf() {
+  size_t index = 0;
+  bool found = false;
+  ((found = found || std::is_same_v<T, List>, index += !found), ...);
+  return index;
+}
+
+template <typename Pass>
+struct RequiresOf {
+  using Type = std::tuple<>;
+};
+
+template <typename Pass>
+  requires requires { typename Pass::Requires; }
+struct RequiresOf<Pass> {
+  using Type = typename Pass::Requires;
+};
+
+template <size_t Index, typename Pass, typename... Passes>
+constexpr bool RequirementsPrecede() {
+  return []<typename... Deps>(std::tuple<Deps...>*) {
+    // Not fused at all means it ran in an earlier traversal
+    return (((IndexOf<Deps, Passes...>() < Index) || (IndexOf<Deps, Passes...>() == sizeof...(Passes))) && ...);
+  }(static_cast<typename RequiresOf<Pass>::Type*>(nullptr));
+}
+
+}  // namespace detail
+
+//////////////////////////////////////////////////////////////////////
+
+template <typename... Passes>
+class FusedWalker : public Walker<FusedWalker<Passes...>> {
+  static_assert(
+      []<size_t... I>(std::index_sequence<I...>) {
+        return (detail::RequirementsPrecede<I, Passes, Passes...>() && ...);
+      }(std::index_sequence_for<Passes...>{}),
+      "A pass must come after the passes it Requires");
+
+ public:
+  explicit FusedWalker(Passes&... passes) : passes_{&passes...} {
+  }
+
+  bool Enter(TreeNode* node) {
+    bool descend = false;
+
+    ForEachPass([&]<size_t I>(auto& pass) {
+      if (skipping_[I] != nullptr) {
+        return;
+      }
+
+      if constexpr (requires { pass.Enter(node); }) {
+        if (!pass.Enter(node)) {
+          skipping_[I] = node;
+          return;
+        }
+      }
+
+      descend = true;
+    });
+
+    // Children are only loaded if some pass wants them
+    return descend;
+  }
+
+  void Leave(TreeNode* node) {
+    ForEachPass([&]<size_t I>(auto& pass) {
+      if (skipping_[I] != nullptr && skipping_[I] != node) {
+        return;
+      }
+
+      skipping_[I] = nullptr;
+
+      if constexpr (requires { pass.Leave(node); }) {
+        pass.Leave(node);
+      }
+    });
+  }
+
+ private:
+  template <typename F>
+  void ForEachPass(F&& fn) {
+    [&]<size_t... I>(std::index_sequence<I...>) {
+      (fn.template operator()<I>(*std::get<I>(passes_)), ...);
+    }(std::index_sequence_for<Passes...>{});
+  }
+
+ private:
+  std::tuple<Passes*...> passes_;
+
+  // Root of the subtree a pass currently skips, nullptr if none
+  std::array<TreeNode*, sizeof...(Passes)> skipping_{};
+};
+
+template <typename... Passes>
+FusedWalker(Passes&...) -> FusedWalker<Passes...>;
+
+//////////////////////////////////////////////////////////////////////
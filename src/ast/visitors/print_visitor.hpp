@@ -33,7 +33,7 @@ class PrintVisitor : public Visitor {
   void VisitFunDecl(FunDeclStatement* node) override {
     os_ << "fun " << node->GetName() << " ";
     for (const auto& param : node->params) {
-      os_ << param.value.identifier << " ";
+      os_ << param.value.identifier.View() << " ";
     }
 
     os_ << " = ";
@@ -59,12 +59,12 @@ class PrintVisitor : public Visitor {
   }
 
   void VisitFnCall(FnCallExpression* node) override {
-    os_ << node->name.value.identifier << "(";
+    os_ << node->name.value.identifier.View() << "(";
     for (const auto& arg : node->args) {
       arg->Accept(this);
       os_ << ", ";
     }
-    os_ << node->name.value.identifier << ")";
+    os_ << node->name.value.identifier.View() << ")";
   }
 
   void VisitBlock(BlockExpression* node) override {
@@ -93,7 +93,7 @@ class PrintVisitor : public Visitor {
       }
 
       case lex::TokenType::kString: {
-        os_ << "\"" << node->literal.value.string << "\"";
+        os_ << "\"" << node->literal.value.string.View() << "\"";
         break;
       }
 
@@ -104,7 +104,7 @@ class PrintVisitor : public Visitor {
   }
 
   void VisitVarAccess(VarAccessExpression* node) override {
-    os_ << node->variable.value.identifier;
+    os_ << node->variable.value.identifier.View();
   }
 
   void VisitReturn(ReturnExpression* node) override {
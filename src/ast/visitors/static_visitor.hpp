@@ -0,0 +1,79 @@
+#pragma once
+
+#include <ast/expressions.hpp>
+#include <ast/declarations.hpp>
+#include <ast/statements.hpp>
+
+#include <fmt/core.h>
+
+//////////////////////////////////////////////////////////////////////
+
+// Visitor without virtual calls: Visit switches on the node kind and
+// calls the Derived::Visit* overload directly, so passes can be inlined
+// and return real values instead of going through a member.
+//
+//   class Evaluator : public StaticVisitor<Evaluator, int64_t> {
+//    public:
+//     int64_t VisitBinary(BinaryExpression* node) {
+//       return Visit(node->lhs) + Visit(node->rhs);
+//     }
+//     ...
+//   };
+//
+// Derived has to provide every Visit* of Visitor (with any return type
+// convertible to Result). The virtual Visitor / Accept pair keeps
+// working for existing passes.
+
+template <typename Derived, typename Result = void>
+class StaticVisitor {
+ public:
+  Result Visit(TreeNode* node) {
+    FMT_ASSERT(node, "Error: visiting null node\n");
+
+    switch (node->GetKind()) {
+      /* Statements */
+      case NodeKind::kExprStatement:
+        return Self().VisitExprStatement(static_cast<ExprStatement*>(node));
+      case NodeKind::kAssignment:
+        return Self().VisitAssignment(static_cast<AssignmentStatement*>(node));
+
+      /* Declarations */
+      case NodeKind::kVarDecl:
+        return Self().VisitVarDecl(static_cast<VarDeclStatement*>(node));
+      case NodeKind::kFunDecl:
+        return Self().VisitFunDecl(static_cast<FunDeclStatement*>(node));
+
+      /* Expressions */
+      case NodeKind::kComparison:
+        return Self().VisitComparison(static_cast<ComparisonExpression*>(node));
+      case NodeKind::kBinary:
+        return Self().VisitBinary(static_cast<BinaryExpression*>(node));
+      case NodeKind::kUnary:
+        return Self().VisitUnary(static_cast<UnaryExpression*>(node));
+      case NodeKind::kFnCall:
+        return Self().VisitFnCall(static_cast<FnCallExpression*>(node));
+      case NodeKind::kBlock:
+        return Self().VisitBlock(static_cast<BlockExpression*>(node));
+      case NodeKind::kIf:
+        return Self().VisitIf(static_cast<IfExpression*>(node));
+      case NodeKind::kLiteral:
+        return Self().VisitLiteral(static_cast<LiteralExpression*>(node));
+      case NodeKind::kReturn:
+        return Self().VisitReturn(static_cast<ReturnExpression*>(node));
+
+      /* Lvalues */
+      case NodeKind::kVarAccess:
+        return Self().VisitVarAccess(static_cast<VarAccessExpression*>(node));
+    }
+
+    FMT_ASSERT(false, "Unknown node kind\n");
+    __builtin_unreachable();
+  }
+
+ private:
+  Derived& Self() {
+    return static_cast<Derived&>(*this);
+  }
+};
+
+//////////////////////////////////////////////////////////////////////
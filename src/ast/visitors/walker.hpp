@@ -0,0 +1,174 @@
+#pragma once
+
+#include <ast/expressions.hpp>
+#include <ast/declarations.hpp>
+#include <ast/statements.hpp>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+
+// Calls `fn(child)` for every non-null child of `node`, left to right
+// in source order
+
+template <typename F>
+void ForEachChild(TreeNode* node, F&& fn) {
+  auto visit = [&fn](TreeNode* child) {
+    if (child != nullptr) {
+      fn(child);
+    }
+  };
+
+  switch (node->GetKind()) {
+    /* Statements */
+    case NodeKind::kExprStatement:
+      visit(static_cast<ExprStatement*>(node)->expr);
+      break;
+
+    case NodeKind::kAssignment: {
+      auto* assignment = static_cast<AssignmentStatement*>(node);
+      visit(assignment->lhs);
+      visit(assignment->rhs);
+      break;
+    }
+
+    /* Declarations */
+    case NodeKind::kVarDecl:
+      visit(static_cast<VarDeclStatement*>(node)->rhs);
+      break;
+
+    case NodeKind::kFunDecl:
+      visit(static_cast<FunDeclStatement*>(node)->body);
+      break;
+
+    /* Expressions */
+    case NodeKind::kComparison: {
+      auto* comparison = static_cast<ComparisonExpression*>(node);
+      visit(comparison->lhs);
+      visit(comparison->rhs);
+      break;
+    }
+
+    case NodeKind::kBinary: {
+      auto* binary = static_cast<BinaryExpression*>(node);
+      visit(binary->lhs);
+      visit(binary->rhs);
+      break;
+    }
+
+    case NodeKind::kUnary:
+      visit(static_cast<UnaryExpression*>(node)->operand);
+      break;
+
+    case NodeKind::kFnCall:
+      for (auto* arg : static_cast<FnCallExpression*>(node)->args) {
+        visit(arg);
+      }
+      break;
+
+    case NodeKind::kBlock:
+      for (auto* statement : static_cast<BlockExpression*>(node)->statements) {
+        visit(statement);
+      }
+      break;
+
+    case NodeKind::kIf: {
+      auto* if_expr = static_cast<IfExpression*>(node);
+      visit(if_expr->condition_expr);
+      visit(if_expr->true_expr);
+      visit(if_expr->false_expr);
+      break;
+    }
+
+    case NodeKind::kReturn:
+      visit(static_cast<ReturnExpression*>(node)->expression);
+      break;
+
+    case NodeKind::kLiteral:
+    case NodeKind::kVarAccess:
+      break;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+// Depth-first traversal with an explicit work stack on the heap: the
+// C++ stack depth does not grow with the depth of the tree. Derived
+// overrides the hooks it needs:
+//
+//   // Pre-order, return false to skip the children of `node`
+//   bool Enter(TreeNode* node);
+//
+//   // Post-order, also called for nodes whose children were skipped
+//   void Leave(TreeNode* node);
+//
+//   class CountCalls : public Walker<CountCalls> {
+//    public:
+//     bool Enter(TreeNode* node) {
+//       calls += isa<FnCallExpression>(node);
+//       return true;
+//     }
+//     size_t calls = 0;
+//   };
+//
+// The stack is kept between walks, so a walker reused over many trees
+// allocates only while the deepest one is seen.
+
+template <typename Derived>
+class Walker {
+ public:
+  void Walk(TreeNode* root) {
+    FMT_ASSERT(root, "Error: walking null tree\n");
+    FMT_ASSERT(stack_.empty(), "Walker is not reentrant\n");
+
+    stack_.push_back({root, false});
+
+    while (!stack_.empty()) {
+      auto [node, leaving] = stack_.back();
+      stack_.pop_back();
+
+      if (leaving) {
+        Self().Leave(node);
+        continue;
+      }
+
+      stack_.push_back({node, true});
+
+      if (!Self().Enter(node)) {
+        continue;
+      }
+
+      // Pushed reversed so that the leftmost child is popped first
+      size_t first = stack_.size();
+      ForEachChild(node, [this](TreeNode* child) {
+        stack_.push_back({child, false});
+      });
+      std::reverse(stack_.begin() + first, stack_.end());
+    }
+  }
+
+  bool Enter(TreeNode*) {
+    return true;
+  }
+
+  void Leave(TreeNode*) {
+  }
+
+ private:
+  Derived& Self() {
+    return static_cast<Derived&>(*this);
+  }
+
+ private:
+  struct Frame {
+    TreeNode* node;
+    bool leaving;
+  };
+
+  std::vector<Frame> stack_;
+};
+
+//////////////////////////////////////////////////////////////////////
@@ -0,0 +1,94 @@
+#include <cache/artifact_cache.hpp>
+
+#include <util/hash.hpp>
+
+#include <fmt/format.h>
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <system_error>
+#include <atomic>
+#include <cerrno>
+
+namespace cache {
+
+////////////////////////////////////////////////////////////////////
+
+ContentKey ContentKey::Of(std::string_view text) {
+  return {util::HashBytes(text), text.size()};
+}
+
+std::string ContentKey::FileName(std::string_view kind) const {
+  return fmt::format("{:016x}-{:x}.{}", hash, size, kind);
+}
+
+////////////////////////////////////////////////////////////////////
+
+ArtifactCache::ArtifactCache(std::filesystem::path directory) : directory_{std::move(directory)} {
+  std::filesystem::create_directories(directory_);
+}
+
+const std::filesystem::path& ArtifactCache::Directory() const {
+  return directory_;
+}
+
+////////////////////////////////////////////////////////////////////
+
+std::optional<lex::MappedFile> ArtifactCache::Load(const ContentKey& key, std::string_view kind) const {
+  try {
+    return lex::MappedFile{directory_ / key.FileName(kind)};
+  } catch (const std::system_error&) {
+    return std::nullopt;  // Missing or unreadable, a miss either way
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+
+static bool WriteAll(int fd, std::string_view bytes) {
+  while (!bytes.empty()) {
+    ssize_t written = ::write(fd, bytes.data(), bytes.size());
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    bytes.remove_prefix(written);
+  }
+  return true;
+}
+
+bool ArtifactCache::Store(const ContentKey& key, std::string_view kind, std::string_view bytes) const {
+  static std::atomic<uint64_t> counter{0};
+
+  auto target = directory_ / key.FileName(kind);
+
+  // Unique among processes (pid) and among threads of this one
+  auto temporary = directory_ / fmt::format(".{}.{}.{}.tmp", key.FileName(kind), ::getpid(), counter++);
+
+  int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+
+  bool written = WriteAll(fd, bytes);
+  written = (::close(fd) == 0) && written;
+
+  // rename(2) replaces the target atomically
+  if (!written || ::rename(temporary.c_str(), target.c_str()) != 0) {
+    ::unlink(temporary.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+void ArtifactCache::Remove(const ContentKey& key, std::string_view kind) const {
+  ::unlink((directory_ / key.FileName(kind)).c_str());
+}
+
+////////////////////////////////////////////////////////////////////
+
+}  // namespace cache
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <lex/mapped_file.hpp>
+
+#include <filesystem>
+#include <string_view>
+#include <optional>
+#include <cstdint>
+#include <string>
+
+namespace cache {
+
+//////////////////////////////////////////////////////////////////////
+
+// Identity of a source text: its 64-bit content hash and its length.
+// Renaming or touching a file keeps the key, any edit changes it.
+
+struct ContentKey {
+  uint64_t hash = 0;
+  uint64_t size = 0;
+
+  static ContentKey Of(std::string_view text);
+
+  // "<hash>-<size>.<kind>"
+  std::string FileName(std::string_view kind) const;
+
+  friend bool operator==(const ContentKey&, const ContentKey&) = default;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// Directory of artifacts addressed by the key of the source they were
+// produced from and their kind ("ast1" for the version 1 serialized
+// AST, later typed IR, QBE output, ...). The kind carries the version
+// of the artifact format, bumping it invalidates old entries.
+//
+// Entries are written to a unique temporary file in the directory and
+// renamed over the final name, so readers (other builds sharing the
+// cache) see either no entry or a complete one. There is no locking:
+// two builds producing the same entry both write it, the last rename
+// wins, and the contents are the same anyway.
+
+class ArtifactCache {
+ public:
+  // Creates the directory if needed
+  explicit ArtifactCache(std::filesystem::path directory);
+
+  std::optional<lex::MappedFile> Load(const ContentKey& key, std::string_view kind) const;
+
+  // The cache is an optimization: failing to write is not an error of
+  // the build, returns false
+  bool Store(const ContentKey& key, std::string_view kind, std::string_view bytes) const;
+
+  // Drops an entry which turned out to be unreadable
+  void Remove(const ContentKey& key, std::string_view kind) const;
+
+  const std::filesystem::path& Directory() const;
+
+ private:
+  std::filesystem::path directory_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace cache
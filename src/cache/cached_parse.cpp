@@ -0,0 +1,81 @@
+#include <cache/cached_parse.hpp>
+
+#include <ast/serialize.hpp>
+
+#include <parse/parser.hpp>
+
+#include <lex/source_map.hpp>
+#include <lex/lexer.hpp>
+
+#include <fmt/format.h>
+
+namespace cache {
+
+////////////////////////////////////////////////////////////////////
+
+static const std::string kAstKind = fmt::format("ast{}", kAstFormatVersion);
+
+// nullopt if the entry is unusable: then it is treated as a miss
+static std::optional<std::vector<Declaration*>> LoadAst(std::string_view bytes, Arena& arena, uint32_t file_id) {
+  try {
+    std::vector<Declaration*> declarations;
+
+    for (auto* node : DecodeAst(bytes, arena, file_id)) {
+      auto* declaration = dyn_cast<Declaration>(node);
+      if (declaration == nullptr) {
+        return std::nullopt;
+      }
+      declarations.push_back(declaration);
+    }
+
+    return declarations;
+  } catch (const AstReadError&) {
+    return std::nullopt;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+
+CachedParse ParseCached(const std::filesystem::path& path, const ArtifactCache& cache, Arena& arena) {
+  lex::MappedFile file{path};
+  auto text = file.View();
+
+  auto& map = lex::SourceMap::Session();
+  uint32_t file_id = map.AddFile(path.string());
+  map.Lines(file_id).Scan(text, 0);
+
+  auto key = ContentKey::Of(text);
+
+  CachedParse result;
+  result.file_id = file_id;
+
+  if (auto artifact = cache.Load(key, kAstKind)) {
+    // Nodes of a rejected entry stay in the arena unreachable
+    if (auto declarations = LoadAst(artifact->View(), arena, file_id)) {
+      result.declarations = std::move(*declarations);
+      result.hit = true;
+      return result;
+    }
+
+    cache.Remove(key, kAstKind);
+  }
+
+  lex::Lexer lexer{lex::SourceSlice{text, 0, file_id, /*has_sentinel=*/true}};
+  Parser parser{lexer, arena};
+
+  result.declarations = parser.ParseFile();
+
+  if (!parser.GetErrors().Empty()) {
+    result.errors = parser.FormatErrors();
+    return result;
+  }
+
+  std::vector<TreeNode*> roots{result.declarations.begin(), result.declarations.end()};
+  cache.Store(key, kAstKind, EncodeAst(roots));
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////
+
+}  // namespace cache
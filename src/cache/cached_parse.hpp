@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cache/artifact_cache.hpp>
+
+#include <ast/declarations.hpp>
+#include <ast/arena.hpp>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace cache {
+
+//////////////////////////////////////////////////////////////////////
+
+struct CachedParse {
+  std::vector<Declaration*> declarations;
+
+  // The front-end was skipped
+  bool hit = false;
+
+  // Formatted syntax errors, files with errors are not cached
+  std::string errors;
+
+  // SourceMap entry of the file
+  uint32_t file_id = 0;
+};
+
+// Front-end of one file through the cache: the file is mapped and
+// hashed; on a hit the stored AST is loaded into `arena` and neither
+// the lexer nor the parser runs. On a miss the file is parsed as
+// usual and the AST is stored for the next build.
+//
+// Either way the file is registered in the SourceMap under `path`
+// with its lines indexed, locations point into it. The entry is the
+// caller's to remove (`file_id`) once the tree is done with.
+
+CachedParse ParseCached(const std::filesystem::path& path, const ArtifactCache& cache, Arena& arena);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace cache
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <lex/token_type.hpp>
+
+#include <string_view>
+#include <cstdint>
+#include <array>
+
+namespace lex::dfa {
+
+//////////////////////////////////////////////////////////////////////
+
+// To add an operator put its TokenType here, the spelling comes from
+// FormatTokenType. The transition tables below are regenerated at
+// compile time.
+
+inline constexpr TokenType kOperators[] = {
+    TokenType::kPlus,  //
+    TokenType::kMinus,
+    TokenType::kStar,
+    TokenType::kDiv,
+    TokenType::kAssign,
+    TokenType::kEquals,
+    TokenType::kNotEq,
+    TokenType::kNot,
+    TokenType::kLess,
+    TokenType::kGreater,
+    TokenType::kLeftParen,
+    TokenType::kRightParen,
+    TokenType::kLeftCBrace,
+    TokenType::kRightCBrace,
+    TokenType::kComma,
+    TokenType::kColon,
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// What the first symbol of a token decides
+
+enum class Start : uint8_t {
+  kInvalid,
+  kWhitespace,
+  kComment,
+  kOperator,
+  kNumber,
+  kString,
+  kWord,
+  kEnd,
+};
+
+//////////////////////////////////////////////////////////////////////
+
+inline constexpr size_t kMaxClasses = 32;
+inline constexpr size_t kMaxStates = 64;
+
+using State = uint8_t;
+
+// State 0 is the start, it is also used as "no transition"
+inline constexpr State kReject = 0;
+
+struct Tables {
+  std::array<Start, 256> start{};
+
+  // Operator symbols get classes 1.., everything else is class 0
+  std::array<uint8_t, 256> symbol_class{};
+
+  std::array<std::array<State, kMaxClasses>, kMaxStates> next{};
+  std::array<TokenType, kMaxStates> accept{};
+  std::array<bool, kMaxStates> accepting{};
+
+  size_t classes{1};
+  size_t states{1};
+};
+
+//////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+constexpr uint8_t Index(char symbol) {
+  return static_cast<uint8_t>(symbol);
+}
+
+constexpr Tables Generate() {
+  Tables tables{};
+
+  for (int ch = 'a'; ch <= 'z'; ++ch) {
+    tables.start[ch] = Start::kWord;
+    tables.start[ch - 'a' + 'A'] = Start::kWord;
+  }
+  tables.start[Index('_')] = Start::kWord;
+
+  for (int ch = '0'; ch <= '9'; ++ch) {
+    tables.start[ch] = Start::kNumber;
+  }
+
+  tables.start[Index(' ')] = Start::kWhitespace;
+  tables.start[Index('\t')] = Start::kWhitespace;
+  tables.start[Index('\n')] = Start::kWhitespace;
+  tables.start[Index('#')] = Start::kComment;
+  tables.start[Index('"')] = Start::kString;
+  tables.start[Index('\0')] = Start::kEnd;
+
+  // Build a trie of the spellings, its nodes are the states
+  for (auto type : kOperators) {
+    std::string_view spelling = FormatTokenType(type);
+    State state = 0;
+
+    for (char symbol : spelling) {
+      tables.start[Index(symbol)] = Start::kOperator;
+
+      uint8_t& symbol_class = tables.symbol_class[Index(symbol)];
+      if (symbol_class == 0) {
+        symbol_class = tables.classes++;
+      }
+
+      State& next = tables.next[state][symbol_class];
+      if (next == kReject) {
+        next = tables.states++;
+      }
+
+      state = next;
+    }
+
+    tables.accept[state] = type;
+    tables.accepting[state] = true;
+  }
+
+  return tables;
+}
+
+// Longest match without backtracking works only if every prefix of an
+// operator is an operator itself (like `=` for `==`)
+constexpr bool EveryStateAccepts(const Tables& tables) {
+  for (State state = 1; state < tables.states; ++state) {
+    if (!tables.accepting[state]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace detail
+
+//////////////////////////////////////////////////////////////////////
+
+inline constexpr Tables kTables = detail::Generate();
+
+static_assert(kTables.classes <= kMaxClasses && kTables.states <= kMaxStates,  //
+              "Operator tables overflow, bump kMaxClasses/kMaxStates");
+
+static_assert(detail::EveryStateAccepts(kTables),  //
+              "Operator prefix is not a token, the lexer would need to backtrack");
+
+//////////////////////////////////////////////////////////////////////
+
+inline Start StartOf(char symbol) {
+  return kTables.start[detail::Index(symbol)];
+}
+
+inline State Transition(State state, char symbol) {
+  return kTables.next[state][kTables.symbol_class[detail::Index(symbol)]];
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace lex::dfa
@@ -2,63 +2,127 @@
 
 #include <lex/token_type.hpp>
 
-#include <string>
-#include <map>
-
-#include <fmt/core.h>
+#include <string_view>
+#include <algorithm>
+#include <optional>
+#include <cstdint>
+#include <array>
 
 namespace lex {
 
-class IdentTable {
- public:
-  IdentTable() {
-    Populate();
+//////////////////////////////////////////////////////////////////////
+
+// To add a keyword put its TokenType here, the spelling comes from
+// FormatTokenType. The hash below is regenerated at compile time.
+
+inline constexpr TokenType kKeywords[] = {
+    TokenType::kTrue,  //
+    TokenType::kFalse,
+    TokenType::kFun,
+    TokenType::kVar,
+    TokenType::kIf,
+    TokenType::kThen,
+    TokenType::kElse,
+    TokenType::kReturn,
+};
+
+//////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+// Smallest power of two with at most 50% load
+inline constexpr size_t kKeywordBits = [] {
+  size_t bits = 1;
+  while ((size_t{1} << bits) < 2 * std::size(kKeywords)) {
+    ++bits;
   }
+  return bits;
+}();
+
+struct KeywordSlot {
+  std::string_view spelling;
+  TokenType type{};
+};
+
+struct KeywordLayout {
+  std::array<KeywordSlot, size_t{1} << kKeywordBits> slots{};
+
+  uint32_t seed{0};
+  size_t min_length{0};
+  size_t max_length{0};
+};
+
+// Length and three symbols are enough to tell the keywords apart,
+// multiplying by an odd `seed` spreads them into distinct slots
+constexpr size_t HashWord(std::string_view word, uint32_t seed) {
+  uint64_t key = word.size();
+  key |= uint64_t{static_cast<uint8_t>(word[0])} << 8;
+  key |= uint64_t{static_cast<uint8_t>(word[1 % word.size()])} << 16;
+  key |= uint64_t{static_cast<uint8_t>(word[word.size() - 1])} << 24;
+  return (key * (seed * 0x9E3779B97F4A7C15ull)) >> (64 - kKeywordBits);
+}
 
-  // Use-of-string-view-for-map-lookup
-  // https://stackoverflow.com/questions/35525777
+constexpr KeywordLayout GenerateKeywordLayout() {
+  KeywordLayout layout{};
 
-  std::optional<TokenType> LookupWord(const std::string_view word) {
-    auto it = map_.find(word);
-    return (it != map_.end()) ? std::optional(it->second) : std::nullopt;
+  layout.min_length = SIZE_MAX;
+  for (auto type : kKeywords) {
+    size_t length = std::string_view{FormatTokenType(type)}.size();
+    layout.min_length = std::min(layout.min_length, length);
+    layout.max_length = std::max(layout.max_length, length);
   }
 
- private:
-  void Populate() {
-    /* One-two character tokens */
-    // map_.emplace("+",  TokenType::kPlus);
-    // map_.emplace("-",  TokenType::kMinus);
-    // map_.emplace("*",  TokenType::kStar);
-    // map_.emplace("/",  TokenType::kDiv);
-    // map_.emplace("=",  TokenType::kAssign);
-    // map_.emplace("==", TokenType::kEquals);
-    // map_.emplace("!=", TokenType::kNotEq);
-    // map_.emplace("!",  TokenType::kNot);
-    // map_.emplace("<",  TokenType::kLess);
-    // map_.emplace(">",  TokenType::kGreater);
-    // map_.emplace("(",  TokenType::kLeftParen);
-    // map_.emplace(")",  TokenType::kRightParen);
-    // map_.emplace("{",  TokenType::kLeftCBrace);
-    // map_.emplace("}",  TokenType::kRightCBrace);
-    // map_.emplace(",",  TokenType::kComma);
-    // map_.emplace(";",  TokenType::kColon);
-
-    /* Keywords */
-    map_.emplace("true",    TokenType::kTrue);
-    map_.emplace("false",   TokenType::kFalse);
-    map_.emplace("fun",     TokenType::kFun);
-    map_.emplace("var",     TokenType::kVar);
-    map_.emplace("if",      TokenType::kIf);
-    map_.emplace("then",    TokenType::kThen);
-    map_.emplace("else",    TokenType::kElse);
-    map_.emplace("return",  TokenType::kReturn);
+  for (uint32_t seed = 1; seed < 100'000; seed += 2) {
+    decltype(layout.slots) slots{};
+    bool collision = false;
+
+    for (auto type : kKeywords) {
+      std::string_view spelling = FormatTokenType(type);
+      KeywordSlot& slot = slots[HashWord(spelling, seed)];
+
+      if (!slot.spelling.empty()) {
+        collision = true;
+        break;
+      }
+
+      slot = {spelling, type};
+    }
+
+    if (!collision) {
+      layout.slots = slots;
+      layout.seed = seed;
+      return layout;
+    }
   }
 
- private:
-  // What-are-transparent-comparators
-  // https://stackoverflow.com/questions/20317413
+  return layout;  // seed == 0 fails the static_assert below
+}
+
+inline constexpr KeywordLayout kKeywordLayout = GenerateKeywordLayout();
+
+static_assert(kKeywordLayout.seed != 0, "No perfect hash for the keyword set, extend HashWord");
+
+}  // namespace detail
+
+//////////////////////////////////////////////////////////////////////
 
-  std::map<std::string, TokenType, std::less<>> map_;
+// Keyword lookup through a perfect hash: one multiply, one probe and
+// one string compare per word. No heap, nothing to construct.
+
+class IdentTable {
+ public:
+  static constexpr std::optional<TokenType> LookupWord(const std::string_view word) {
+    const auto& layout = detail::kKeywordLayout;
+
+    if (word.size() < layout.min_length || word.size() > layout.max_length) {
+      return std::nullopt;
+    }
+
+    const auto& slot = layout.slots[detail::HashWord(word, layout.seed)];
+    return (slot.spelling == word) ? std::optional(slot.type) : std::nullopt;
+  }
 };
 
+//////////////////////////////////////////////////////////////////////
+
 }  // namespace lex
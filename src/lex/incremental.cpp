@@ -0,0 +1,68 @@
+#include <lex/incremental.hpp>
+#include <lex/lexer.hpp>
+
+#include <algorithm>
+
+namespace lex {
+
+////////////////////////////////////////////////////////////////////
+
+RelexedRange Relex(TokenBuffer& tokens, std::string_view text, const TextEdit& edit) {
+  FMT_ASSERT(tokens.Size() > 0, "Token buffer must end with EOF\n");
+
+  uint32_t file_id = tokens.GetLocation(tokens.Size() - 1).file_id;
+  int64_t delta = static_cast<int64_t>(edit.inserted.size()) - static_cast<int64_t>(edit.removed);
+
+  size_t old_edit_end = edit.offset + edit.removed;
+  size_t new_edit_end = edit.offset + edit.inserted.size();
+
+  // A token reads one symbol past its end (to see that it ended), so
+  // the one right before the edit may grow into it: restart from the
+  // token before the first one starting inside or after the edit.
+  // Without such a token the edit is in the leading whitespace or
+  // comments, which may now end elsewhere: restart from the top.
+  size_t restart = tokens.LowerBound(edit.offset);
+  size_t restart_offset = 0;
+
+  if (restart > 0) {
+    --restart;
+    restart_offset = tokens.GetLocation(restart).offset;
+  }
+
+  Lexer lexer{SourceSlice{text.substr(restart_offset), restart_offset, file_id, /*has_sentinel=*/true}};
+
+  // First old token which is not touched by the edit
+  size_t old = tokens.LowerBound(old_edit_end);
+
+  TokenBuffer fresh;
+
+  while (true) {
+    Token token = lexer.GetNextToken();
+
+    if (token.location.offset >= new_edit_end) {
+      while (old < tokens.Size() && tokens.GetLocation(old).offset + delta < token.location.offset) {
+        ++old;
+      }
+
+      if (old < tokens.Size() && tokens.GetLocation(old).offset + delta == token.location.offset) {
+        break;  // Resynchronized
+      }
+    }
+
+    fresh.Append(token);
+
+    if (token.type == TokenType::kEOF) {
+      old = tokens.Size();
+      break;
+    }
+  }
+
+  SourceMap::Session().Lines(file_id).Replace(edit.offset, edit.removed, edit.inserted);
+
+  tokens.Replace(restart, old, fresh, fresh.Size());
+  tokens.ShiftOffsets(restart + fresh.Size(), delta);
+
+  return {restart, restart + fresh.Size()};
+}
+
+}  // namespace lex
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <lex/token_buffer.hpp>
+
+#include <string_view>
+#include <cstddef>
+
+namespace lex {
+
+//////////////////////////////////////////////////////////////////////
+
+// `removed` bytes at `offset` were replaced by `inserted`
+struct TextEdit {
+  size_t offset = 0;
+  size_t removed = 0;
+  std::string_view inserted;
+};
+
+// Tokens [begin, end) of the updated buffer were lexed anew, the ones
+// behind them were only moved
+struct RelexedRange {
+  size_t begin = 0;
+  size_t end = 0;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// Brings `tokens` (of the text before the edit) up to date with `text`
+// (the text after it) and updates the line index of the file.
+//
+// Lexing restarts at the last token which the edit can not have
+// changed and stops as soon as a new token starts where a (shifted) old
+// one did: the lexer only looks forward, so from there on both streams
+// are the same. Cost is proportional to the edited region plus one
+// pass shifting the offsets of the tokens behind it.
+//
+// `text.data()[text.size()]` must be a readable '\0', which is the case
+// for std::string and MappedFile.
+
+RelexedRange Relex(TokenBuffer& tokens, std::string_view text, const TextEdit& edit);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace lex
@@ -0,0 +1,77 @@
+#include <lex/interner.hpp>
+
+namespace lex {
+
+////////////////////////////////////////////////////////////////////
+
+Interner::Interner() : pages_{std::make_unique<std::atomic<std::string_view*>[]>(kMaxPages)} {
+  [[maybe_unused]] auto empty = Intern("");
+  FMT_ASSERT(empty == 0, "The empty string must get the zero id\n");
+}
+
+Interner::~Interner() {
+  for (size_t i = 0; i < kMaxPages; ++i) {
+    delete[] pages_[i].load(std::memory_order_relaxed);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+
+SymbolId Interner::Intern(std::string_view text) {
+  Shard& shard = shards_[std::hash<std::string_view>{}(text) % kShards];
+  std::lock_guard guard{shard.mutex};
+
+  if (auto it = shard.ids.find(text); it != shard.ids.end()) {
+    return it->second;
+  }
+
+  auto copy = shard.pool.Copy(text);
+  SymbolId id = next_id_.fetch_add(1, std::memory_order_relaxed);
+
+  Slot(id) = copy;
+  shard.ids.emplace(copy, id);
+
+  return id;
+}
+
+////////////////////////////////////////////////////////////////////
+
+std::string_view Interner::View(SymbolId id) const {
+  std::string_view* page = pages_[id >> kPageBits].load(std::memory_order_acquire);
+  FMT_ASSERT(page != nullptr && id < Size(), "Unknown symbol id\n");
+  return page[id & (kPageSize - 1)];
+}
+
+size_t Interner::Size() const {
+  return next_id_.load(std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////////////
+
+std::string_view& Interner::Slot(SymbolId id) {
+  size_t index = id >> kPageBits;
+  FMT_ASSERT(index < kMaxPages, "Too many distinct symbols\n");
+
+  std::string_view* page = pages_[index].load(std::memory_order_acquire);
+
+  if (page == nullptr) [[unlikely]] {
+    std::lock_guard guard{pages_mutex_};
+
+    page = pages_[index].load(std::memory_order_relaxed);
+    if (page == nullptr) {
+      page = new std::string_view[kPageSize];
+      pages_[index].store(page, std::memory_order_release);
+    }
+  }
+
+  return page[id & (kPageSize - 1)];
+}
+
+////////////////////////////////////////////////////////////////////
+
+Interner& Interner::Session() {
+  static Interner interner;
+  return interner;
+}
+
+}  // namespace lex
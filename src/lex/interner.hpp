@@ -0,0 +1,134 @@
+#pragma once
+
+#include <lex/string_pool.hpp>
+
+#include <fmt/core.h>
+
+#include <unordered_map>
+#include <string_view>
+#include <functional>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <array>
+
+namespace lex {
+
+//////////////////////////////////////////////////////////////////////
+
+using SymbolId = uint32_t;
+
+//////////////////////////////////////////////////////////////////////
+
+// Maps every distinct identifier or string literal of the session to
+// a dense id. Ids are handed out in order, 0 is the empty string.
+//
+// Thread-safe: interning locks one of the shards (chosen by the hash
+// of the string), looking up the text of an id takes no locks at all.
+
+class Interner {
+ public:
+  Interner();
+
+  Interner(const Interner&) = delete;
+  Interner& operator=(const Interner&) = delete;
+
+  ~Interner();
+
+  SymbolId Intern(std::string_view text);
+
+  std::string_view View(SymbolId id) const;
+
+  size_t Size() const;
+
+  // The table of the compilation session, which is the whole process
+  static Interner& Session();
+
+ private:
+  static constexpr size_t kShards = 16;
+
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<std::string_view, SymbolId> ids;
+    StringPool pool;
+  };
+
+  // Texts are stored in fixed-size pages which never move, so readers
+  // do not race with the writers appending new pages
+  static constexpr size_t kPageBits = 12;
+  static constexpr size_t kPageSize = size_t{1} << kPageBits;
+  static constexpr size_t kMaxPages = size_t{1} << 16;
+
+  std::string_view& Slot(SymbolId id);
+
+ private:
+  std::array<Shard, kShards> shards_;
+
+  std::atomic<SymbolId> next_id_{0};
+
+  std::unique_ptr<std::atomic<std::string_view*>[]> pages_;
+  std::mutex pages_mutex_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// Interned string: equality is an integer compare, hashing costs
+// nothing. Converts to std::string_view for everything else.
+
+struct Symbol {
+  SymbolId id{0};
+
+  Symbol() = default;
+
+  Symbol(std::string_view text) : id{Interner::Session().Intern(text)} {
+  }
+
+  Symbol(const char* text) : Symbol(std::string_view{text}) {
+  }
+
+  static Symbol FromId(SymbolId id) {
+    Symbol symbol;
+    symbol.id = id;
+    return symbol;
+  }
+
+  std::string_view View() const {
+    return Interner::Session().View(id);
+  }
+
+  operator std::string_view() const {
+    return View();
+  }
+
+  friend bool operator==(Symbol lhs, Symbol rhs) {
+    return lhs.id == rhs.id;
+  }
+
+  friend bool operator==(Symbol lhs, std::string_view rhs) {
+    return lhs.View() == rhs;
+  }
+
+  friend bool operator==(Symbol lhs, const char* rhs) {
+    return lhs.View() == rhs;
+  }
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace lex
+
+template <>
+struct std::hash<lex::Symbol> {
+  size_t operator()(lex::Symbol symbol) const noexcept {
+    return symbol.id;
+  }
+};
+
+template <>
+struct fmt::formatter<lex::Symbol> : fmt::formatter<std::string_view> {
+  template <typename FormatContext>
+  auto format(lex::Symbol symbol, FormatContext& ctx) const {
+    return fmt::formatter<std::string_view>::format(symbol.View(), ctx);
+  }
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+namespace lex::errors {
+
+//////////////////////////////////////////////////////////////////////
+
+// Malformed tokens do not stop the lexer: it returns a kError token
+// whose value says what was wrong, and goes on after the bad spelling.
+// The parser reports such tokens together with its own errors.
+
+enum class LexErrorCode : uint8_t {
+  // Numeric literal out of the 64-bit range
+  kNumberOverflow,
+
+  // "0x" or "0b" not followed by a digit of that radix
+  kMissingDigits,
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace lex::errors
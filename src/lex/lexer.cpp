@@ -1,30 +1,69 @@
 #include <lex/lexer.hpp>
+#include <lex/lex_error.hpp>
 
 namespace lex {
 
 Lexer::Lexer(std::istream& source) : scanner_(source) {
 }
 
+Lexer::Lexer(std::istream& source, StreamingMode mode) : scanner_(source, mode) {
+}
+
+Lexer::Lexer(const std::filesystem::path& path) : scanner_(path) {
+}
+
+Lexer::Lexer(SourceSlice slice) : scanner_(slice) {
+}
+
 ////////////////////////////////////////////////////////////////////
 
 Token Lexer::GetNextToken() {
+  scanner_.ClearTokenStart();
+
   SkipWhitespace();
 
   SkipComments();
 
-  if (auto op = MatchOperators()) {
-    return *op;
-  }
+  scanner_.MarkTokenStart();
 
-  if (auto lit = MatchLiterls()) {
-    return *lit;
-  }
+  // One table lookup on the first symbol picks the token class
+  switch (dfa::StartOf(scanner_.CurrentSymbol())) {
+    case dfa::Start::kEnd: {
+      Token token{};
+      token.type     = TokenType::kEOF;
+      token.location = scanner_.CurrentLocation();
+      return token;
+    }
+
+    case dfa::Start::kOperator:
+      return MatchOperator();
+
+    case dfa::Start::kNumber:
+      return MatchNumericLiteral();
+
+    case dfa::Start::kString:
+      return MatchStringLiteral();
 
-  if (auto word = MatchWords()) {
-    return *word;
+    case dfa::Start::kWord:
+      return MatchWord();
+
+    default:
+      FMT_ASSERT(false, "Could not match any token\n");
   }
+}
+
+////////////////////////////////////////////////////////////////////
 
-  FMT_ASSERT(false, "Could not match any token\n");
+TokenBuffer Lexer::TokenizeAll() {
+  TokenBuffer buffer;
+
+  Token token{};
+  do {
+    token = GetNextToken();
+    buffer.Append(token);
+  } while (token.type != TokenType::kEOF);
+
+  return buffer;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -57,6 +96,10 @@ bool Lexer::Matches(lex::TokenType type) {
   return true;
 }
 
+uint32_t Lexer::GetFileId() const {
+  return scanner_.CurrentLocation().file_id;
+}
+
 ////////////////////////////////////////////////////////////////////
 
 Token Lexer::Peek() {
@@ -69,20 +112,14 @@ Token Lexer::Peek() {
 
 ////////////////////////////////////////////////////////////////////
 
-bool IsWhitespace(char ch) {
-  return ch == ' ' || ch == '\n' || ch == '\t';
-}
-
 void Lexer::SkipWhitespace() {
-  while (IsWhitespace(scanner_.CurrentSymbol())) {
-    scanner_.MoveRight();
-  }
+  scanner_.SkipWhitespace();
 }
 
 ////////////////////////////////////////////////////////////////////
 
 void Lexer::SkipComments() {
-  while (scanner_.CurrentSymbol() == '#') {
+  while (dfa::StartOf(scanner_.CurrentSymbol()) == dfa::Start::kComment) {
     scanner_.MoveNextLine();
     SkipWhitespace();
   }
@@ -90,166 +127,116 @@ void Lexer::SkipComments() {
 
 ////////////////////////////////////////////////////////////////////
 
-std::optional<Token> Lexer::MatchOperators() {
-  auto token_type = MatchOperator();
-  if (!token_type) {
-    return std::nullopt;
-  }
+// Maximal munch over the generated operator tables. Every state is
+// accepting (checked in dfa.hpp), so the walk never has to back up.
 
+Token Lexer::MatchOperator() {
   Token token{};
-  token.type     = token_type.value();
   token.location = scanner_.CurrentLocation();
 
+  dfa::State state = dfa::kReject;
+  while (auto next = dfa::Transition(state, scanner_.CurrentSymbol())) {
+    state = next;
+    scanner_.MoveRight();
+  }
+
+  FMT_ASSERT(state != dfa::kReject, "Unknown operator\n");
+  token.type = dfa::kTables.accept[state];
+
   return token;
 }
 
 ////////////////////////////////////////////////////////////////////
 
-std::optional<TokenType> Lexer::MatchOperator() {
-  #define CASE_SINGLE(symbol, token_type) \
-    case symbol: {                        \
-      scanner_.MoveRight();               \
-      return token_type;                  \
-    }
-
-  #define CASE_DOUBLE(symbols, type_single, type_double) \
-    case symbols[0]: {                                   \
-      scanner_.MoveRight();                              \
-      if (scanner_.CurrentSymbol() == symbols[1]) {      \
-        scanner_.MoveRight();                            \
-        return type_double;                              \
-      } else {                                           \
-        return type_single;                              \
-      }                                                  \
-    }
+Token Lexer::MatchNumericLiteral() {
+  Location location = scanner_.CurrentLocation();
 
-  switch (scanner_.CurrentSymbol()) {
-    CASE_SINGLE('+', TokenType::kPlus);
-    CASE_SINGLE('-', TokenType::kMinus);
-    CASE_SINGLE('*', TokenType::kStar);
-    CASE_SINGLE('/', TokenType::kDiv);
-    CASE_DOUBLE("==", TokenType::kAssign, TokenType::kEquals);
-    CASE_DOUBLE("!=", TokenType::kNot, TokenType::kNotEq);
-    CASE_SINGLE('<', TokenType::kLess);
-    CASE_SINGLE('>', TokenType::kGreater);
-    CASE_SINGLE('(', TokenType::kLeftParen);
-    CASE_SINGLE(')', TokenType::kRightParen);
-    CASE_SINGLE('{', TokenType::kLeftCBrace);
-    CASE_SINGLE('}', TokenType::kRightCBrace);
-    CASE_SINGLE(',', TokenType::kComma);
-    CASE_SINGLE(';', TokenType::kColon);
-  };
-
-  #undef CASE_SINGLE
-  #undef CASE_DOUBLE
-
-  return std::nullopt;
-}
+  auto radix = numbers::Radix::kDecimal;
 
-////////////////////////////////////////////////////////////////////
-
-std::optional<Token> Lexer::MatchLiterls() {
-  if (auto num_token = MatchNumericLiteral()) {
-    return num_token;
+  if (scanner_.CurrentSymbol() == '0') {
+    switch (scanner_.NextSymbol() | 0x20) {
+      case 'x':
+        radix = numbers::Radix::kHex;
+        break;
+      case 'b':
+        radix = numbers::Radix::kBinary;
+        break;
+    }
   }
 
-  if (auto string_token = MatchStringLiteral()) {
-    return string_token;
+  if (radix != numbers::Radix::kDecimal) {
+    scanner_.MoveRight();  // skip "0x" / "0b"
+    scanner_.MoveRight();
   }
 
-  return std::nullopt;
-}
-
-////////////////////////////////////////////////////////////////////
-
-std::optional<int32_t> CharToDigit(char ch) {
-  return (ch >= '0' && ch <= '9') ? std::optional<int32_t>(ch - '0') : std::nullopt;
-}
- 
-std::optional<Token> Lexer::MatchNumericLiteral() {
-  Location location = scanner_.CurrentLocation();
-
-  int32_t number{0};
-  bool valid{false};
-
-  while (auto digit = CharToDigit(scanner_.CurrentSymbol())) {
-    number *= 10;
-    number += *digit;
+  size_t start = scanner_.CurrentOffset();
+  size_t length = scanner_.SkipDigits(radix);
 
-    valid = true;
+  Token token{};
+  token.location = location;
 
-    scanner_.MoveRight();
+  if (length == 0) {
+    token.type = TokenType::kError;
+    token.value.error = errors::LexErrorCode::kMissingDigits;
+    return token;
   }
 
-  if (!valid) {
-    return std::nullopt;
+  auto number = numbers::ParseDigits(radix, scanner_.SubString(start, length));
+  if (!number) {
+    token.type = TokenType::kError;
+    token.value.error = errors::LexErrorCode::kNumberOverflow;
+    return token;
   }
 
-  Token token{};
   token.type = TokenType::kNumber;
-  token.value.number = number;
-  token.location = location;
+  token.value.number = *number;
 
   return token;
 }
 
 ////////////////////////////////////////////////////////////////////
 
-std::optional<Token> Lexer::MatchStringLiteral() {
-  if (scanner_.CurrentSymbol() != '\"') {
-    return std::nullopt;
-  }
-
+Token Lexer::MatchStringLiteral() {
   Location location = scanner_.CurrentLocation();
 
   scanner_.MoveRight();  // skip opening '\"'
   size_t start = scanner_.CurrentOffset();
   size_t length = 0;
-  while (scanner_.CurrentSymbol() != '\"') {
+  while (scanner_.CurrentSymbol() != '\"' && scanner_.CurrentSymbol() != '\0') {
     scanner_.MoveRight();
     ++length;
   }
+
+  FMT_ASSERT(scanner_.CurrentSymbol() == '\"', "Unterminated string literal\n");
   scanner_.MoveRight();  // skip closing '\"'
 
   Token token{};
   token.type = TokenType::kString;
   token.location = location;
-  token.value.string = scanner_.SubString(start, length);
+  token.value.string = Symbol{scanner_.SubString(start, length)};
 
   return token;
 }
 
 ////////////////////////////////////////////////////////////////////
 
-bool IsWordSymbol(char symbol) {
-  return std::isalnum(symbol) || symbol == '_';
-}
-
-std::optional<Token> Lexer::MatchWords() {
+Token Lexer::MatchWord() {
   Location location = scanner_.CurrentLocation();
 
   size_t start = scanner_.CurrentOffset();
-  size_t length = 0;
-  while (IsWordSymbol(scanner_.CurrentSymbol())) {
-    scanner_.MoveRight();
-    ++length;
-  }
-
-  if (length == 0) {
-    return std::nullopt;
-  }
+  size_t length = scanner_.SkipWord();
 
   Token token{};
   token.location = location;
 
   auto word = scanner_.SubString(start, length);
 
-  auto keyword_type = table_.LookupWord(word);
+  auto keyword_type = IdentTable::LookupWord(word);
   if (keyword_type) {
     token.type = keyword_type.value();
   } else {
     token.type = TokenType::kIdentifier;
-    token.value.identifier = word;
+    token.value.identifier = Symbol{word};
   }
 
   return token;
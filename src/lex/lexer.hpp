@@ -1,6 +1,8 @@
 #pragma once
 
 #include <lex/ident_table.hpp>
+#include <lex/dfa.hpp>
+#include <lex/token_buffer.hpp>
 #include <lex/token.hpp>
 
 #include <fmt/format.h>
@@ -14,8 +16,20 @@ class Lexer {
  public:
   Lexer(std::istream& source);
 
+  // Bounded memory lexing of arbitrary sized (piped) input
+  Lexer(std::istream& source, StreamingMode mode);
+
+  // Lex a file through a read-only memory mapping
+  explicit Lexer(const std::filesystem::path& path);
+
+  // Lex a piece of a file, see lex/parallel_lexer.hpp
+  explicit Lexer(SourceSlice slice);
+
   Token GetNextToken();
 
+  // Lex the rest of the input in one go, up to and including kEOF
+  TokenBuffer TokenizeAll();
+
   void Advance();
 
   Token Peek();
@@ -25,6 +39,9 @@ class Lexer {
   // Check current token type and maybe consume it.
   bool Matches(lex::TokenType type);
 
+  // The SourceMap entry of the input, see SourceMap::RemoveFile
+  uint32_t GetFileId() const;
+
  private:
   void SkipWhitespace();
 
@@ -32,21 +49,15 @@ class Lexer {
 
   ////////////////////////////////////////////////////////////////////
 
-  std::optional<Token> MatchOperators();
-
-  std::optional<TokenType> MatchOperator();
+  Token MatchOperator();
 
   ////////////////////////////////////////////////////////////////////
 
-  std::optional<Token> MatchLiterls();
-
-  std::optional<Token> MatchNumericLiteral();
-
-  std::optional<Token> MatchStringLiteral();
+  Token MatchNumericLiteral();
 
-  std::optional<Token> MatchCharLiteral();
+  Token MatchStringLiteral();
 
-  std::optional<Token> MatchWords();
+  Token MatchWord();
 
   ////////////////////////////////////////////////////////////////////
 
@@ -60,7 +71,6 @@ class Lexer {
   bool advanced_{false};
 
   Scanner scanner_;
-  IdentTable table_;
 };
 
 }  // namespace lex
@@ -1,20 +1,33 @@
 #pragma once
 
-#include <fmt/core.h>
-
+#include <cstdint>
 #include <cstddef>
 #include <string>
 
 namespace lex {
 
-struct Location {
+//////////////////////////////////////////////////////////////////////
+
+struct LineColumn {
   size_t lineno = 0;
   size_t columnno = 0;
+};
+
+//////////////////////////////////////////////////////////////////////
 
-  std::string Format() const {
-    return fmt::format("line = {}, column = {}",  //
-                       lineno + 1, columnno + 1);
-  }
+// Byte offset into a source file. Lines and columns are computed only
+// when someone asks, see lex/source_map.hpp.
+
+struct Location {
+  uint32_t offset = 0;
+  uint32_t file_id = 0;
+
+  // Binary search in the line index of the file
+  LineColumn Resolve() const;
+
+  std::string Format() const;
 };
 
+//////////////////////////////////////////////////////////////////////
+
 }  // namespace lex
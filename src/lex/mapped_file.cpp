@@ -0,0 +1,102 @@
+#include <lex/mapped_file.hpp>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <system_error>
+#include <utility>
+#include <cerrno>
+
+namespace lex {
+
+////////////////////////////////////////////////////////////////////
+
+static std::system_error LastError(const std::filesystem::path& path) {
+  return std::system_error(errno, std::generic_category(), path.string());
+}
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw LastError(path);
+  }
+
+  struct stat info {};
+  if (::fstat(fd, &info) != 0) {
+    auto error = LastError(path);
+    ::close(fd);
+    throw error;
+  }
+
+  size_t page = ::sysconf(_SC_PAGESIZE);
+  size_ = info.st_size;
+  mapped_size_ = (size_ + 1 + page - 1) / page * page;  // Room for '\0'
+
+  // Reserve zeroed anonymous pages first, then map the file over their
+  // prefix: the tail behind the contents always reads as the sentinel.
+  void* region = ::mmap(nullptr, mapped_size_, PROT_READ,  //
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (region == MAP_FAILED) {
+    auto error = LastError(path);
+    ::close(fd);
+    throw error;
+  }
+
+  base_ = static_cast<char*>(region);
+
+  if (size_ > 0) {
+    void* file = ::mmap(base_, size_, PROT_READ,  //
+                        MAP_PRIVATE | MAP_FIXED | MAP_POPULATE, fd, 0);
+    if (file == MAP_FAILED) {
+      auto error = LastError(path);
+      ::close(fd);
+      Unmap();
+      throw error;
+    }
+
+    ::madvise(base_, size_, MADV_SEQUENTIAL);
+  }
+
+  ::close(fd);
+}
+
+////////////////////////////////////////////////////////////////////
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : base_{std::exchange(other.base_, nullptr)},
+      size_{std::exchange(other.size_, 0)},
+      mapped_size_{std::exchange(other.mapped_size_, 0)} {
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    Unmap();
+    base_ = std::exchange(other.base_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+    mapped_size_ = std::exchange(other.mapped_size_, 0);
+  }
+  return *this;
+}
+
+MappedFile::~MappedFile() {
+  Unmap();
+}
+
+////////////////////////////////////////////////////////////////////
+
+std::string_view MappedFile::View() const {
+  return base_ ? std::string_view(base_, size_) : std::string_view{};
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MappedFile::Unmap() {
+  if (base_) {
+    ::munmap(base_, mapped_size_);
+    base_ = nullptr;
+  }
+}
+
+}  // namespace lex
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+#include <cstddef>
+
+namespace lex {
+
+//////////////////////////////////////////////////////////////////////
+
+// Read-only view of a whole file backed by mmap.
+//
+// The mapping is always followed by at least one zero byte, so
+// `View().data()[View().size()]` is a valid '\0' sentinel exactly like
+// for std::string. Even when the file size is a multiple of the page
+// size reading the sentinel does not fault.
+
+class MappedFile {
+ public:
+  MappedFile() = default;
+  explicit MappedFile(const std::filesystem::path& path);
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  ~MappedFile();
+
+  std::string_view View() const;
+
+ private:
+  void Unmap();
+
+ private:
+  char* base_{nullptr};
+
+  size_t size_{0};
+  size_t mapped_size_{0};
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace lex
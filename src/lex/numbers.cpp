@@ -0,0 +1,172 @@
+#include <lex/numbers.hpp>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <bit>
+
+namespace lex::numbers {
+
+////////////////////////////////////////////////////////////////////
+//                          Scalar
+////////////////////////////////////////////////////////////////////
+
+static bool IsDecimal(char ch) {
+  return ch >= '0' && ch <= '9';
+}
+
+static bool IsBinary(char ch) {
+  return ch == '0' || ch == '1';
+}
+
+static bool IsHex(char ch) {
+  char lower = ch | 0x20;
+  return IsDecimal(ch) || (lower >= 'a' && lower <= 'f');
+}
+
+static uint64_t DigitValue(char ch) {
+  return IsDecimal(ch) ? ch - '0' : (ch | 0x20) - 'a' + 10;
+}
+
+template <typename Predicate>
+static size_t SpanScalar(const char* begin, const char* end, Predicate predicate) {
+  const char* cur = begin;
+  while (cur != end && predicate(*cur)) {
+    ++cur;
+  }
+  return cur - begin;
+}
+
+////////////////////////////////////////////////////////////////////
+//                           SWAR
+////////////////////////////////////////////////////////////////////
+
+// Eight ASCII digits packed into a little-endian word, the first digit
+// in the lowest byte. Only whole words inside the range are loaded.
+
+static constexpr bool kSwar = (std::endian::native == std::endian::little);
+
+static uint64_t LoadWord(const char* ptr) {
+  uint64_t word;
+  std::memcpy(&word, ptr, sizeof(word));
+  return word;
+}
+
+static bool AllDecimal(uint64_t word) {
+  // High nibbles are all 3, and adding 6 to a low nibble does not carry
+  return (word & 0xF0F0F0F0F0F0F0F0) == 0x3030303030303030 &&
+         ((word + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) == 0x3030303030303030;
+}
+
+// Combines neighbouring lanes: 1-digit lanes into 2-digit ones, then
+// into 4-digit and 8-digit ones. Three multiplications instead of eight.
+static uint64_t EightDigitsValue(uint64_t word) {
+  word = ((word & 0x0F0F0F0F0F0F0F0F) * 2561) >> 8;
+  word = ((word & 0x00FF00FF00FF00FF) * 6553601) >> 16;
+  return ((word & 0x0000FFFF0000FFFF) * 42949672960001) >> 32;
+}
+
+////////////////////////////////////////////////////////////////////
+
+static size_t SpanDecimal(const char* begin, const char* end) {
+  const char* cur = begin;
+
+  if constexpr (kSwar) {
+    while (end - cur >= 8 && AllDecimal(LoadWord(cur))) {
+      cur += 8;
+    }
+  }
+
+  return (cur - begin) + SpanScalar(cur, end, IsDecimal);
+}
+
+static size_t SpanBinary(const char* begin, const char* end) {
+  return SpanScalar(begin, end, IsBinary);
+}
+
+static size_t SpanHex(const char* begin, const char* end) {
+  return SpanScalar(begin, end, IsHex);
+}
+
+SpanFn SpanFor(Radix radix) {
+  switch (radix) {
+    case Radix::kBinary:
+      return SpanBinary;
+    case Radix::kDecimal:
+      return SpanDecimal;
+    case Radix::kHex:
+      return SpanHex;
+  }
+
+  FMT_ASSERT(false, "Unknown radix\n");
+}
+
+////////////////////////////////////////////////////////////////////
+
+static std::optional<uint64_t> ParseDecimal(std::string_view digits) {
+  uint64_t value = 0;
+  size_t i = 0;
+
+  if constexpr (kSwar) {
+    for (; i + 8 <= digits.size(); i += 8) {
+      if (__builtin_mul_overflow(value, uint64_t{100'000'000}, &value) ||
+          __builtin_add_overflow(value, EightDigitsValue(LoadWord(digits.data() + i)), &value)) {
+        return std::nullopt;
+      }
+    }
+  }
+
+  for (; i < digits.size(); ++i) {
+    if (__builtin_mul_overflow(value, uint64_t{10}, &value) ||
+        __builtin_add_overflow(value, DigitValue(digits[i]), &value)) {
+      return std::nullopt;
+    }
+  }
+
+  return value;
+}
+
+// Every digit is a fixed number of bits, so overflow is a matter of
+// counting the significant ones
+static std::optional<uint64_t> ParsePowerOfTwo(std::string_view digits, int bits_per_digit) {
+  digits.remove_prefix(std::min(digits.find_first_not_of('0'), digits.size()));
+
+  if (digits.size() * bits_per_digit > 64) {
+    return std::nullopt;
+  }
+
+  uint64_t value = 0;
+  for (char digit : digits) {
+    value = (value << bits_per_digit) | DigitValue(digit);
+  }
+
+  return value;
+}
+
+std::optional<int64_t> ParseDigits(Radix radix, std::string_view digits) {
+  FMT_ASSERT(!digits.empty(), "Numeric literal without digits\n");
+
+  std::optional<uint64_t> value;
+
+  switch (radix) {
+    case Radix::kBinary:
+      value = ParsePowerOfTwo(digits, 1);
+      break;
+    case Radix::kDecimal:
+      value = ParseDecimal(digits);
+      break;
+    case Radix::kHex:
+      value = ParsePowerOfTwo(digits, 4);
+      break;
+  }
+
+  if (!value || *value > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+    return std::nullopt;
+  }
+
+  return static_cast<int64_t>(*value);
+}
+
+}  // namespace lex::numbers
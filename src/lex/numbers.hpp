@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string_view>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+
+namespace lex::numbers {
+
+//////////////////////////////////////////////////////////////////////
+
+// Integer literals: `123`, `0x7f` / `0X7F` and `0b101` / `0B101`.
+// Every form must fit into int64_t, the sign is a separate token.
+
+enum class Radix {
+  kBinary = 2,
+  kDecimal = 10,
+  kHex = 16,
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// Kernel in the style of lex/scan_kernels.hpp: the length of the
+// longest prefix of [begin, end) made of digits of the radix. Decimal
+// runs are checked 8 bytes at a time (SWAR).
+
+using SpanFn = size_t (*)(const char* begin, const char* end);
+
+SpanFn SpanFor(Radix radix);
+
+// `digits` must be non-empty and contain only digits of the radix.
+// Decimal digits are converted 8 at a time. Returns nullopt on overflow.
+
+std::optional<int64_t> ParseDigits(Radix radix, std::string_view digits);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace lex::numbers
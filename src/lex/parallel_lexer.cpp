@@ -0,0 +1,122 @@
+#include <lex/parallel_lexer.hpp>
+#include <lex/mapped_file.hpp>
+#include <lex/lexer.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+
+namespace lex {
+
+////////////////////////////////////////////////////////////////////
+
+std::vector<size_t> FindSplitPoints(std::string_view text, size_t chunks) {
+  std::vector<size_t> splits{0};
+  chunks = std::max<size_t>(chunks, 1);
+
+  const char* begin = text.data();
+  const char* end = begin + text.size();
+
+  size_t next_target = text.size() / chunks;
+
+  for (const char* cur = begin; cur < end && splits.size() < chunks;) {
+    switch (*cur) {
+      case '"': {
+        auto* closing = static_cast<const char*>(std::memchr(cur + 1, '"', end - cur - 1));
+        if (closing == nullptr) {
+          cur = end;  // Unterminated, the lexer reports it
+        } else {
+          cur = closing + 1;
+        }
+        break;
+      }
+
+      case '#': {
+        // The '\n' closing the comment is handled by the next iteration
+        auto* newline = static_cast<const char*>(std::memchr(cur, '\n', end - cur));
+        cur = (newline == nullptr) ? end : newline;
+        break;
+      }
+
+      case '\n': {
+        ++cur;
+
+        size_t offset = cur - begin;
+        if (offset >= next_target && cur != end) {
+          splits.push_back(offset);
+          next_target = splits.size() * text.size() / chunks;
+        }
+        break;
+      }
+
+      default:
+        ++cur;
+    }
+  }
+
+  splits.push_back(text.size());
+  return splits;
+}
+
+////////////////////////////////////////////////////////////////////
+
+TokenBuffer TokenizeParallel(std::string_view text, uint32_t file_id,  //
+                             util::ThreadPool& pool, ParallelMode mode) {
+  size_t chunks = std::min(text.size() / std::max<size_t>(mode.min_chunk_size, 1), pool.Threads());
+
+  if (chunks <= 1) {
+    return Lexer{SourceSlice{text, 0, file_id}}.TokenizeAll();
+  }
+
+  auto splits = FindSplitPoints(text, chunks);
+
+  std::vector<std::future<TokenBuffer>> parts;
+  for (size_t i = 0; i + 1 < splits.size(); ++i) {
+    SourceSlice slice{text.substr(splits[i], splits[i + 1] - splits[i]), splits[i], file_id};
+
+    parts.push_back(pool.Submit([slice] {
+      return Lexer{slice}.TokenizeAll();
+    }));
+  }
+
+  // Every task views `text`: none may outlive the call, not even when
+  // another one failed and `get` is about to rethrow
+  for (auto& part : parts) {
+    part.wait();
+  }
+
+  std::vector<TokenBuffer> tokens;
+  size_t total = 0;
+
+  for (auto& part : parts) {
+    tokens.push_back(part.get());
+    total += tokens.back().Size();
+  }
+
+  // Every part ends with its own kEOF, only the last one is real
+  TokenBuffer result;
+  result.Reserve(total - (tokens.size() - 1));
+
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    bool last = (i + 1 == tokens.size());
+    result.Append(tokens[i], last ? tokens[i].Size() : tokens[i].Size() - 1);
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////
+
+TokenBuffer TokenizeParallel(const std::filesystem::path& path,  //
+                             util::ThreadPool& pool, ParallelMode mode) {
+  MappedFile file{path};
+
+  auto& map = SourceMap::Session();
+  uint32_t file_id = map.AddFile(path.string());
+  map.Lines(file_id).Scan(file.View(), 0);
+
+  // Slices are copied and symbols interned, the mapping can go after
+  return TokenizeParallel(file.View(), file_id, pool, mode);
+}
+
+}  // namespace lex
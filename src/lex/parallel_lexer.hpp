@@ -0,0 +1,52 @@
+#pragma once
+
+#include <lex/token_buffer.hpp>
+#include <lex/scanner.hpp>
+
+#include <util/thread_pool.hpp>
+
+#include <string_view>
+#include <filesystem>
+#include <vector>
+
+namespace lex {
+
+//////////////////////////////////////////////////////////////////////
+
+struct ParallelMode {
+  // Smaller files are not worth the hand-off to the pool
+  size_t min_chunk_size = 1 << 20;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// Offsets splitting `text` into at most `chunks` pieces of about equal
+// size. A split always follows a '\n' which is neither inside a string
+// literal nor inside a comment, so lexing the pieces separately yields
+// exactly the tokens of the whole text. The result starts with 0 and
+// ends with `text.size()`.
+//
+// One sequential pass, but it only looks for '"', '#' and '\n', and
+// jumps over literals and comments with memchr.
+
+std::vector<size_t> FindSplitPoints(std::string_view text, size_t chunks);
+
+//////////////////////////////////////////////////////////////////////
+
+// Lexes the pieces on the pool and concatenates the results. The token
+// stream is the same as the one of the sequential Lexer::TokenizeAll:
+// slices keep file offsets, so no location needs fixing up.
+//
+// `text` is the whole contents of `file_id`, which must already be
+// registered in the SourceMap with its lines indexed.
+
+TokenBuffer TokenizeParallel(std::string_view text, uint32_t file_id,  //
+                             util::ThreadPool& pool, ParallelMode mode = {});
+
+// Maps and registers the file, then lexes it as above
+TokenBuffer TokenizeParallel(const std::filesystem::path& path,  //
+                             util::ThreadPool& pool, ParallelMode mode = {});
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace lex
@@ -0,0 +1,281 @@
+#include <lex/scan_kernels.hpp>
+
+#include <fmt/core.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LEX_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+namespace lex::kernels {
+
+////////////////////////////////////////////////////////////////////
+//                          Scalar
+////////////////////////////////////////////////////////////////////
+
+// ASCII-only on purpose: std::isalnum depends on the locale and is
+// undefined for negative chars
+
+static bool IsWhitespace(char ch) {
+  return ch == ' ' || ch == '\n' || ch == '\t';
+}
+
+static bool IsWord(char ch) {
+  char lower = ch | 0x20;
+  return (lower >= 'a' && lower <= 'z') || (ch >= '0' && ch <= '9') || ch == '_';
+}
+
+static bool IsNotNewline(char ch) {
+  return ch != '\n';
+}
+
+template <typename Predicate>
+static size_t SpanScalar(const char* begin, const char* end, Predicate predicate) {
+  const char* cur = begin;
+  while (cur != end && predicate(*cur)) {
+    ++cur;
+  }
+  return cur - begin;
+}
+
+static size_t SpanWhitespaceScalar(const char* begin, const char* end) {
+  return SpanScalar(begin, end, IsWhitespace);
+}
+
+static size_t SpanWordScalar(const char* begin, const char* end) {
+  return SpanScalar(begin, end, IsWord);
+}
+
+static size_t SpanLineScalar(const char* begin, const char* end) {
+  return SpanScalar(begin, end, IsNotNewline);
+}
+
+#ifdef LEX_KERNELS_X86
+
+////////////////////////////////////////////////////////////////////
+//                           SSE2
+////////////////////////////////////////////////////////////////////
+
+// Vector loops process whole blocks only, the tail is finished by the
+// scalar loop: the bytes behind `end` may not be mapped at all
+
+#define LEX_SSE2 __attribute__((target("sse2")))
+
+LEX_SSE2 static __m128i InRange(__m128i v, char lo, char hi) {
+  // Unsigned lo <= v <= hi  <=>  max(v, lo) == v && min(v, hi) == v
+  __m128i above = _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(lo)), v);
+  __m128i below = _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(hi)), v);
+  return _mm_and_si128(above, below);
+}
+
+LEX_SSE2 static __m128i WhitespaceMask(__m128i v) {
+  __m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+  __m128i newline = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+  __m128i tab = _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'));
+  return _mm_or_si128(space, _mm_or_si128(newline, tab));
+}
+
+LEX_SSE2 static __m128i WordMask(__m128i v) {
+  __m128i alpha = InRange(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+  __m128i digit = InRange(v, '0', '9');
+  __m128i underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+  return _mm_or_si128(alpha, _mm_or_si128(digit, underscore));
+}
+
+LEX_SSE2 static __m128i LineMask(__m128i v) {
+  return _mm_xor_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_set1_epi8(-1));
+}
+
+template <__m128i (*Mask)(__m128i), bool (*Predicate)(char)>
+LEX_SSE2 static size_t SpanSse2(const char* begin, const char* end) {
+  const char* cur = begin;
+
+  while (end - cur >= 16) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur));
+    unsigned misses = ~_mm_movemask_epi8(Mask(block)) & 0xFFFF;
+    if (misses != 0) {
+      return (cur - begin) + __builtin_ctz(misses);
+    }
+    cur += 16;
+  }
+
+  return (cur - begin) + SpanScalar(cur, end, Predicate);
+}
+
+static size_t SpanWhitespaceSse2(const char* begin, const char* end) {
+  return SpanSse2<WhitespaceMask, IsWhitespace>(begin, end);
+}
+
+static size_t SpanWordSse2(const char* begin, const char* end) {
+  return SpanSse2<WordMask, IsWord>(begin, end);
+}
+
+static size_t SpanLineSse2(const char* begin, const char* end) {
+  return SpanSse2<LineMask, IsNotNewline>(begin, end);
+}
+
+////////////////////////////////////////////////////////////////////
+//                           AVX2
+////////////////////////////////////////////////////////////////////
+
+#define LEX_AVX2 __attribute__((target("avx2")))
+
+LEX_AVX2 static __m256i InRange(__m256i v, char lo, char hi) {
+  __m256i above = _mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8(lo)), v);
+  __m256i below = _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(hi)), v);
+  return _mm256_and_si256(above, below);
+}
+
+LEX_AVX2 static __m256i WhitespaceMask(__m256i v) {
+  __m256i space = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+  __m256i newline = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+  __m256i tab = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'));
+  return _mm256_or_si256(space, _mm256_or_si256(newline, tab));
+}
+
+LEX_AVX2 static __m256i WordMask(__m256i v) {
+  __m256i alpha = InRange(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+  __m256i digit = InRange(v, '0', '9');
+  __m256i underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+  return _mm256_or_si256(alpha, _mm256_or_si256(digit, underscore));
+}
+
+LEX_AVX2 static __m256i LineMask(__m256i v) {
+  return _mm256_xor_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_set1_epi8(-1));
+}
+
+template <__m256i (*Mask)(__m256i), bool (*Predicate)(char)>
+LEX_AVX2 static size_t SpanAvx2(const char* begin, const char* end) {
+  const char* cur = begin;
+
+  while (end - cur >= 32) {
+    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cur));
+    unsigned misses = ~static_cast<unsigned>(_mm256_movemask_epi8(Mask(block)));
+    if (misses != 0) {
+      return (cur - begin) + __builtin_ctz(misses);
+    }
+    cur += 32;
+  }
+
+  return (cur - begin) + SpanScalar(cur, end, Predicate);
+}
+
+LEX_AVX2 static size_t SpanWhitespaceAvx2(const char* begin, const char* end) {
+  return SpanAvx2<WhitespaceMask, IsWhitespace>(begin, end);
+}
+
+LEX_AVX2 static size_t SpanWordAvx2(const char* begin, const char* end) {
+  return SpanAvx2<WordMask, IsWord>(begin, end);
+}
+
+LEX_AVX2 static size_t SpanLineAvx2(const char* begin, const char* end) {
+  return SpanAvx2<LineMask, IsNotNewline>(begin, end);
+}
+
+#undef LEX_SSE2
+#undef LEX_AVX2
+
+#endif
+
+////////////////////////////////////////////////////////////////////
+//                         Dispatch
+////////////////////////////////////////////////////////////////////
+
+using SpanFn = size_t (*)(const char*, const char*);
+
+struct KernelTable {
+  Isa isa;
+  SpanFn whitespace;
+  SpanFn word;
+  SpanFn line;
+};
+
+static constexpr KernelTable kScalarTable{
+    Isa::kScalar, SpanWhitespaceScalar, SpanWordScalar, SpanLineScalar};
+
+static KernelTable TableFor(Isa isa) {
+  switch (isa) {
+#ifdef LEX_KERNELS_X86
+    case Isa::kAvx2:
+      return {isa, SpanWhitespaceAvx2, SpanWordAvx2, SpanLineAvx2};
+    case Isa::kSse2:
+      return {isa, SpanWhitespaceSse2, SpanWordSse2, SpanLineSse2};
+#endif
+    default:
+      return kScalarTable;
+  }
+}
+
+static KernelTable SelectBest() {
+  for (auto isa : {Isa::kAvx2, Isa::kSse2}) {
+    if (IsSupported(isa)) {
+      return TableFor(isa);
+    }
+  }
+  return kScalarTable;
+}
+
+// Constant-initialized, so lexing from other static initializers
+// still works (with scalar kernels) before the upgrade below runs
+constinit static KernelTable active = kScalarTable;
+
+[[maybe_unused]] static const bool upgraded = [] {
+  active = SelectBest();
+  return true;
+}();
+
+////////////////////////////////////////////////////////////////////
+
+// Runs of a single symbol are the common case (one space between
+// tokens), so check the first byte before paying for a vector load
+
+size_t SpanWhitespace(const char* begin, const char* end) {
+  if (begin == end || !IsWhitespace(*begin)) {
+    return 0;
+  }
+  return active.whitespace(begin, end);
+}
+
+size_t SpanWord(const char* begin, const char* end) {
+  if (begin == end || !IsWord(*begin)) {
+    return 0;
+  }
+  return active.word(begin, end);
+}
+
+size_t SpanLine(const char* begin, const char* end) {
+  return active.line(begin, end);
+}
+
+////////////////////////////////////////////////////////////////////
+
+Isa ActiveIsa() {
+  return active.isa;
+}
+
+bool IsSupported(Isa isa) {
+#ifdef LEX_KERNELS_X86
+  __builtin_cpu_init();  // May run before the constructors
+#endif
+
+  switch (isa) {
+#ifdef LEX_KERNELS_X86
+    case Isa::kAvx2:
+      return __builtin_cpu_supports("avx2");
+    case Isa::kSse2:
+      return __builtin_cpu_supports("sse2");
+#endif
+    case Isa::kScalar:
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+void ForceIsa(Isa isa) {
+  FMT_ASSERT(IsSupported(isa), "Instruction set is not supported by the CPU\n");
+  active = TableFor(isa);
+}
+
+}  // namespace lex::kernels
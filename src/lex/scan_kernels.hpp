@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+
+namespace lex::kernels {
+
+//////////////////////////////////////////////////////////////////////
+
+// Vectorized classification of source bytes. Every kernel takes a
+// range [begin, end) and returns the length of its longest prefix of
+// the given class. Kernels never read outside of the range.
+//
+// The implementation is picked once at runtime: AVX2 when the CPU has
+// it, otherwise SSE2 (x86-64 baseline), otherwise scalar loops.
+
+enum class Isa {
+  kScalar,
+  kSse2,
+  kAvx2,
+};
+
+// ' ', '\t', '\n'
+size_t SpanWhitespace(const char* begin, const char* end);
+
+// [A-Za-z0-9_]
+size_t SpanWord(const char* begin, const char* end);
+
+// Anything but '\n'
+size_t SpanLine(const char* begin, const char* end);
+
+//////////////////////////////////////////////////////////////////////
+
+Isa ActiveIsa();
+
+bool IsSupported(Isa isa);
+
+// For tests and benchmarks: all implementations must agree
+void ForceIsa(Isa isa);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace lex::kernels
@@ -1,46 +1,190 @@
 #include <lex/scanner.hpp>
+#include <lex/scan_kernels.hpp>
+
+#include <algorithm>
+#include <cstring>
 
 namespace lex {
 
 Scanner::Scanner(std::istream& source) {
+  RegisterFile("<stream>");
+
   source.seekg(0, source.end);
-  size_t size = source.tellg();
+  auto end = source.tellg();
+
+  if (!source || end < 0) {
+    // Pipes and terminals can not be measured up front
+    source.clear();
+
+    stream_ = &source;
+    chunk_size_ = StreamingMode{}.chunk_size;
+
+    EnsureLookahead();
+    return;
+  }
+
+  size_t size = end;
   source.seekg(0, source.beg);
 
-  buffer_.resize(size);
-  source.read(buffer_.data(), size);
+  owned_.resize(size);
+  source.read(owned_.data(), size);
+
+  buffer_ = owned_;
+  lines_->Scan(buffer_, 0);
 }
 
-const Location& Scanner::CurrentLocation() const {
-  return current_location_;
+Scanner::Scanner(std::istream& source, StreamingMode mode)
+    : stream_{&source}, chunk_size_{mode.chunk_size} {
+  RegisterFile("<stream>");
+  FMT_ASSERT(chunk_size_ > 0, "Empty streaming chunk\n");
+  EnsureLookahead();
 }
 
+Scanner::Scanner(const std::filesystem::path& path) : mapping_{path} {
+  RegisterFile(path.string());
+
+  buffer_ = mapping_.View();
+  lines_->Scan(buffer_, 0);
+}
+
+Scanner::Scanner(SourceSlice slice)
+    : window_begin_{slice.base}, cur_offset_{slice.base}, file_id_{slice.file_id} {
+  if (slice.has_sentinel) {
+    buffer_ = slice.text;
+  } else {
+    owned_ = slice.text;
+    buffer_ = owned_;
+  }
+}
+
+void Scanner::RegisterFile(std::string name) {
+  auto& map = SourceMap::Session();
+  file_id_ = map.AddFile(std::move(name));
+  lines_ = &map.Lines(file_id_);
+}
+
+Location Scanner::CurrentLocation() const {
+  FMT_ASSERT(cur_offset_ <= UINT32_MAX, "Source files are limited to 4GiB\n");
+  return {static_cast<uint32_t>(cur_offset_), file_id_};
+}
+
+// All storages guarantee a readable '\0' right behind the contents,
+// `Step` keeps both the current and the next symbol in the window
+
 char Scanner::CurrentSymbol() const {
-  return buffer_[cur_offset_];
+  return buffer_.data()[cur_offset_ - window_begin_];
 }
 
 char Scanner::NextSymbol() const {
-  return buffer_[cur_offset_ + 1];
+  size_t offset = cur_offset_ - window_begin_;
+  return offset < buffer_.size() ? buffer_.data()[offset + 1] : '\0';
 }
 
 void Scanner::MoveRight() {
-  ++cur_offset_;
-  ++current_location_.columnno;
+  Step();
 }
 
 void Scanner::MoveNextLine() {
-  while (buffer_[cur_offset_++] != '\n') {;}
+  MoveOver(kernels::SpanLine);
+
+  if (CurrentSymbol() == '\n') {
+    Step();
+  }
+}
+
+void Scanner::SkipWhitespace() {
+  MoveOver(kernels::SpanWhitespace);
+}
 
-  ++current_location_.lineno;
-  current_location_.columnno = 0;
+size_t Scanner::SkipWord() {
+  return MoveOver(kernels::SpanWord);
+}
+
+size_t Scanner::SkipDigits(numbers::Radix radix) {
+  return MoveOver(numbers::SpanFor(radix));
 }
 
 size_t Scanner::CurrentOffset() const {
   return cur_offset_;
 }
 
-std::string_view Scanner::SubString(size_t start, size_t length) const {
-  return std::string_view(buffer_).substr(start, length);
+std::string_view Scanner::SubString(size_t start, size_t length) {
+  FMT_ASSERT(start >= window_begin_, "Substring was dropped from the window\n");
+
+  return buffer_.substr(start - window_begin_, length);
+}
+
+void Scanner::MarkTokenStart() {
+  token_start_ = cur_offset_;
+}
+
+void Scanner::ClearTokenStart() {
+  token_start_ = kNoToken;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Scanner::Step() {
+  ++cur_offset_;
+  EnsureLookahead();
+}
+
+void Scanner::EnsureLookahead() {
+  while (cur_offset_ + 1 >= window_begin_ + buffer_.size()) [[unlikely]] {
+    if (!Refill()) {
+      break;
+    }
+  }
+}
+
+size_t Scanner::MoveOver(SpanFn span) {
+  size_t total = 0;
+
+  // Streaming: the run may continue in the next chunk
+  while (true) {
+    const char* cur = buffer_.data() + (cur_offset_ - window_begin_);
+    const char* end = buffer_.data() + buffer_.size();
+
+    size_t length = span(cur, end);
+    bool run_continues = (length > 0 && cur + length == end);
+
+    cur_offset_ += length;
+    total += length;
+    EnsureLookahead();
+
+    if (!run_continues) {
+      return total;
+    }
+  }
+}
+
+bool Scanner::Refill() {
+  if (!stream_ || !*stream_) {
+    return false;  // Whole input is already in memory
+  }
+
+  // Drop everything before the token being matched (or the cursor)
+  size_t keep_from = std::min(token_start_, cur_offset_);
+  size_t dropped = keep_from - window_begin_;
+  size_t kept = buffer_.size() - dropped;
+
+  // Long tokens make the window grow past the chunk size
+  if (owned_.size() < kept + chunk_size_ + 1) {
+    owned_.resize(kept + chunk_size_ + 1);
+  }
+
+  std::memmove(owned_.data(), owned_.data() + dropped, kept);
+  window_begin_ = keep_from;
+
+  stream_->read(owned_.data() + kept, chunk_size_);
+  size_t read = stream_->gcount();
+
+  owned_[kept + read] = '\0';
+  buffer_ = std::string_view(owned_.data(), kept + read);
+
+  lines_->Scan(buffer_.substr(kept), window_begin_ + kept);
+
+  return read > 0;
 }
 
-}  // namespace lex
\ No newline at end of file
+}  // namespace lex
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <lex/token_type.hpp>
-#include <lex/location.hpp>
+#include <lex/source_map.hpp>
+#include <lex/mapped_file.hpp>
+#include <lex/numbers.hpp>
 
 #include <fmt/core.h>
 
@@ -16,11 +18,53 @@ namespace lex {
 
 //////////////////////////////////////////////////////////////////////
 
+// Reads the source chunk by chunk instead of slurping it whole. This
+// is the only mode which works for pipes and other non-seekable streams.
+
+struct StreamingMode {
+  size_t chunk_size = 64 * 1024;
+};
+
+// Part of an already registered (and line-indexed) file, starting at
+// offset `base`. Used to lex a file in pieces (lex/parallel_lexer.hpp)
+// and to re-lex edited regions (lex/incremental.hpp)
+
+struct SourceSlice {
+  std::string_view text;
+  size_t base = 0;
+  uint32_t file_id = 0;
+
+  // `text.data()[text.size()]` is a readable '\0' (the slice runs to
+  // the end of a std::string or a MappedFile), no copy is needed
+  bool has_sentinel = false;
+};
+
+//////////////////////////////////////////////////////////////////////
+
 class Scanner {
  public:
+  // Falls back to streaming if the source is not seekable
   Scanner(std::istream& source);
 
-  const Location& CurrentLocation() const;
+  // Keeps only a window of the input in memory: the current chunk plus
+  // the token being matched. The window is overwritten on refill, so
+  // substrings are valid only until the scanner moves on (the lexer
+  // interns them right away).
+  Scanner(std::istream& source, StreamingMode mode);
+
+  // Maps the file instead of copying it into memory: substrings
+  // handed out by the scanner point directly into the mapped pages.
+  explicit Scanner(const std::filesystem::path& path);
+
+  // Locations are reported relative to the start of the whole file.
+  // Unless it has one, the slice is copied to get a '\0' sentinel.
+  explicit Scanner(SourceSlice slice);
+
+  // Views into the buffer must stay valid
+  Scanner(const Scanner&) = delete;
+  Scanner& operator=(const Scanner&) = delete;
+
+  Location CurrentLocation() const;
 
   char CurrentSymbol() const;
   char NextSymbol() const;
@@ -28,14 +72,51 @@ class Scanner {
   void MoveRight();
   void MoveNextLine();
 
+  // Bulk moves over runs of symbols, see lex/scan_kernels.hpp
+  void SkipWhitespace();
+  size_t SkipWord();
+  size_t SkipDigits(numbers::Radix radix);
+
   size_t CurrentOffset() const;
-  std::string_view SubString(size_t start, size_t length) const;
+  std::string_view SubString(size_t start, size_t length);
+
+  // Streaming mode drops consumed input on refill, bytes starting from
+  // the marked offset are kept until the mark is cleared.
+  void MarkTokenStart();
+  void ClearTokenStart();
 
  private:
-  std::string buffer_;
+  void RegisterFile(std::string name);
+
+  void Step();
+  void EnsureLookahead();
+
+  using SpanFn = size_t (*)(const char*, const char*);
+  size_t MoveOver(SpanFn span);
+  bool Refill();
+
+ private:
+  // Either a copy of the stream, the file mapping or the streaming
+  // window, all of them are terminated by the '\0' sentinel
+  std::string owned_;
+  MappedFile mapping_;
+
+  // Loaded part of the input, starts at `window_begin_`
+  std::string_view buffer_;
+  size_t window_begin_{0};
+
+  // Streaming mode only
+  std::istream* stream_{nullptr};
+  size_t chunk_size_{0};
+  size_t token_start_{kNoToken};
+
+  static constexpr size_t kNoToken = static_cast<size_t>(-1);
 
   size_t cur_offset_{0};
-  Location current_location_{};
+
+  // Lines are indexed as the input arrives (not at all for slices)
+  uint32_t file_id_{0};
+  LineIndex* lines_{nullptr};
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -0,0 +1,142 @@
+#include <lex/source_map.hpp>
+#include <lex/scan_kernels.hpp>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+
+namespace lex {
+
+////////////////////////////////////////////////////////////////////
+
+void LineIndex::Scan(std::string_view text, size_t base) {
+  const char* begin = text.data();
+  const char* end = begin + text.size();
+
+  for (const char* cur = begin;;) {
+    cur += kernels::SpanLine(cur, end);
+    if (cur == end) {
+      break;
+    }
+
+    ++cur;  // Skip '\n'
+    starts_.push_back(base + (cur - begin));
+  }
+}
+
+void LineIndex::Replace(size_t offset, size_t removed, std::string_view inserted) {
+  // Lines starting inside the removed text (right after a removed '\n')
+  auto first = std::upper_bound(starts_.begin(), starts_.end(), offset);
+  auto last = std::upper_bound(first, starts_.end(), offset + removed);
+
+  int64_t delta = static_cast<int64_t>(inserted.size()) - static_cast<int64_t>(removed);
+  for (auto it = last; it != starts_.end(); ++it) {
+    *it += delta;
+  }
+
+  LineIndex added{};
+  added.starts_.clear();
+  added.Scan(inserted, offset);
+
+  auto at = starts_.erase(first, last);
+  starts_.insert(at, added.starts_.begin(), added.starts_.end());
+}
+
+LineColumn LineIndex::Resolve(uint32_t offset) const {
+  auto next_line = std::upper_bound(starts_.begin(), starts_.end(), offset);
+  size_t line = (next_line - starts_.begin()) - 1;
+  return {line, offset - starts_[line]};
+}
+
+size_t LineIndex::LineCount() const {
+  return starts_.size();
+}
+
+////////////////////////////////////////////////////////////////////
+
+SourceMap::SourceMap() {
+  AddFile("<unknown>");
+}
+
+uint32_t SourceMap::AddFile(std::string name) {
+  std::lock_guard guard{mutex_};
+
+  FMT_ASSERT(files_.size() < UINT32_MAX, "Out of file ids\n");
+
+  files_.push_back(std::make_unique<SourceFile>());
+  files_.back()->name = std::move(name);
+
+  return files_.size() - 1;
+}
+
+void SourceMap::RemoveFile(uint32_t file_id) {
+  std::lock_guard guard{mutex_};
+  FMT_ASSERT(file_id != 0, "The reserved file can not be removed\n");
+  FMT_ASSERT(file_id < files_.size() && files_[file_id], "Unknown file id\n");
+
+  // The empty slot stays: the id is never handed out again
+  files_[file_id].reset();
+  ++removed_;
+}
+
+std::string_view SourceMap::FileName(uint32_t file_id) {
+  return File(file_id).name;
+}
+
+LineIndex& SourceMap::Lines(uint32_t file_id) {
+  return File(file_id).lines;
+}
+
+LineColumn SourceMap::Resolve(Location location) {
+  return File(location.file_id).lines.Resolve(location.offset);
+}
+
+size_t SourceMap::FileCount() {
+  std::lock_guard guard{mutex_};
+  return files_.size() - removed_;
+}
+
+SourceMap::SourceFile& SourceMap::File(uint32_t file_id) {
+  std::lock_guard guard{mutex_};
+  FMT_ASSERT(file_id < files_.size(), "Unknown file id\n");
+  FMT_ASSERT(files_[file_id], "Location into a removed file\n");
+  return *files_[file_id];
+}
+
+std::atomic<SourceMap*>& SourceMap::Current() {
+  static SourceMap process_map;
+  static std::atomic<SourceMap*> current{&process_map};
+  return current;
+}
+
+SourceMap& SourceMap::Session() {
+  return *Current().load(std::memory_order_acquire);
+}
+
+////////////////////////////////////////////////////////////////////
+
+SourceScope::SourceScope() : previous_{SourceMap::Current().exchange(&map_, std::memory_order_acq_rel)} {
+}
+
+SourceScope::~SourceScope() {
+  [[maybe_unused]] SourceMap* current = SourceMap::Current().exchange(previous_, std::memory_order_acq_rel);
+  FMT_ASSERT(current == &map_, "Source scopes must end in reverse order\n");
+}
+
+SourceMap& SourceScope::Map() {
+  return map_;
+}
+
+////////////////////////////////////////////////////////////////////
+
+LineColumn Location::Resolve() const {
+  return SourceMap::Session().Resolve(*this);
+}
+
+std::string Location::Format() const {
+  auto [lineno, columnno] = Resolve();
+  return fmt::format("line = {}, column = {}",  //
+                     lineno + 1, columnno + 1);
+}
+
+}  // namespace lex
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <lex/location.hpp>
+
+#include <string_view>
+#include <cstdint>
+#include <memory>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <mutex>
+
+namespace lex {
+
+//////////////////////////////////////////////////////////////////////
+
+// Offsets at which the lines of a file start
+
+class LineIndex {
+ public:
+  // Collect line starts of `text`, which starts at offset `base`
+  void Scan(std::string_view text, size_t base);
+
+  // Keep the index in sync with an edit of the file: `removed` bytes at
+  // `offset` were replaced by `inserted`
+  void Replace(size_t offset, size_t removed, std::string_view inserted);
+
+  LineColumn Resolve(uint32_t offset) const;
+
+  size_t LineCount() const;
+
+ private:
+  std::vector<uint32_t> starts_{0};
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// Files of the compilation session. The id 0 is reserved for locations
+// which do not come from any file (e.g. built by hand in tests).
+//
+// Registrations last until RemoveFile or until the map goes away: a
+// long-lived process (an editor re-parsing on every change) removes
+// the files it is done with, or registers them in a SourceScope which
+// drops them all at once.
+
+class SourceMap {
+ public:
+  SourceMap();
+
+  uint32_t AddFile(std::string name);
+
+  // Frees the name and the line index. The id is not handed out again:
+  // resolving a location into the file fails an assertion instead of
+  // pointing into some other file. No scanner of the file may still be
+  // running.
+  void RemoveFile(uint32_t file_id);
+
+  std::string_view FileName(uint32_t file_id);
+
+  // Only the scanner of the file appends to its index
+  LineIndex& Lines(uint32_t file_id);
+
+  LineColumn Resolve(Location location);
+
+  // Files registered right now, including the reserved one
+  size_t FileCount();
+
+  // The map of the innermost live SourceScope, or the process-wide one
+  static SourceMap& Session();
+
+ private:
+  friend class SourceScope;
+
+  struct SourceFile {
+    std::string name;
+    LineIndex lines;
+  };
+
+  SourceFile& File(uint32_t file_id);
+
+  static std::atomic<SourceMap*>& Current();
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<SourceFile>> files_;
+
+  // Slots of removed files are left empty
+  size_t removed_{0};
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// A compilation session with its own SourceMap: while the scope lives,
+// SourceMap::Session() (so every lexer, loader and Location::Resolve)
+// uses it, and all its files are dropped with it.
+//
+//   {
+//     lex::SourceScope session;
+//     lex::Lexer lexer{path};
+//     ...
+//   }  // Files and line indices are gone, locations are stale
+//
+// Scopes nest and must end in reverse order. They are switched on one
+// thread while no other thread is lexing or resolving locations.
+
+class SourceScope {
+ public:
+  SourceScope();
+  ~SourceScope();
+
+  SourceScope(const SourceScope&) = delete;
+  SourceScope& operator=(const SourceScope&) = delete;
+
+  SourceMap& Map();
+
+ private:
+  SourceMap map_;
+  SourceMap* previous_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace lex
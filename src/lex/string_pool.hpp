@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string_view>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace lex {
+
+//////////////////////////////////////////////////////////////////////
+
+// Owned storage for strings which must outlive the buffer they were
+// read from. Copies are bump-allocated in large blocks and never move.
+
+class StringPool {
+ public:
+  std::string_view Copy(std::string_view text);
+
+ private:
+  static constexpr size_t kBlockSize = 64 * 1024;
+
+  std::vector<std::unique_ptr<char[]>> blocks_;
+
+  char* free_{nullptr};
+  size_t left_{0};
+};
+
+//////////////////////////////////////////////////////////////////////
+
+inline std::string_view StringPool::Copy(std::string_view text) {
+  if (text.size() > left_) {
+    // Oversized strings get a block of their own
+    size_t size = std::max(kBlockSize, text.size());
+    blocks_.push_back(std::make_unique<char[]>(size));
+
+    free_ = blocks_.back().get();
+    left_ = size;
+  }
+
+  std::copy(text.begin(), text.end(), free_);
+  std::string_view copy{free_, text.size()};
+
+  free_ += text.size();
+  left_ -= text.size();
+
+  return copy;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace lex
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <lex/scanner.hpp>
+#include <lex/interner.hpp>
+#include <lex/lex_error.hpp>
 
 #include <variant>
 #include <cstddef>
@@ -10,15 +12,19 @@ namespace lex {
 //////////////////////////////////////////////////////////////////////
 
 struct Token {
-  TokenType type;
+  TokenType type{};
 
+  // Strings and identifiers are interned, see lex/interner.hpp
   union {
-    int32_t number;
-    std::string_view string;
-    std::string_view identifier;
-  } value;
-  
-  Location location;
+    int64_t number;
+    Symbol string;
+    Symbol identifier;
+
+    // kError only
+    errors::LexErrorCode error;
+  } value{};
+
+  Location location{};
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -0,0 +1,175 @@
+#include <lex/token_buffer.hpp>
+
+#include <algorithm>
+
+namespace lex {
+
+////////////////////////////////////////////////////////////////////
+
+void TokenBuffer::Append(const Token& token) {
+  types_.push_back(token.type);
+  locations_.push_back(token.location);
+
+  switch (token.type) {
+    case TokenType::kNumber:
+      payloads_.push_back(token.value.number);
+      break;
+
+    case TokenType::kString:
+    case TokenType::kIdentifier:
+      payloads_.push_back(token.value.identifier.id);
+      break;
+
+    case TokenType::kError:
+      payloads_.push_back(static_cast<uint64_t>(token.value.error));
+      break;
+
+    default:
+      payloads_.push_back(0);
+  }
+}
+
+void TokenBuffer::Append(const TokenBuffer& other, size_t count) {
+  Replace(Size(), Size(), other, count);
+}
+
+void TokenBuffer::Replace(size_t begin, size_t end, const TokenBuffer& other, size_t count) {
+  FMT_ASSERT(begin <= end && end <= Size(), "Replacing tokens out of range\n");
+  FMT_ASSERT(count <= other.Size(), "Inserting more tokens than there are\n");
+
+  auto splice = [&](auto& into, const auto& from) {
+    // Overwrite the common part, then insert or erase the difference
+    size_t common = std::min(end - begin, count);
+    std::copy_n(from.begin(), common, into.begin() + begin);
+
+    if (count > common) {
+      into.insert(into.begin() + begin + common, from.begin() + common, from.begin() + count);
+    } else {
+      into.erase(into.begin() + begin + common, into.begin() + end);
+    }
+  };
+
+  splice(types_, other.types_);
+  splice(locations_, other.locations_);
+  splice(payloads_, other.payloads_);
+}
+
+TokenBuffer TokenBuffer::Slice(size_t begin, size_t end) const {
+  FMT_ASSERT(begin <= end && end < Size(), "Slicing tokens out of range\n");
+
+  TokenBuffer slice;
+  slice.types_.assign(types_.begin() + begin, types_.begin() + end);
+  slice.locations_.assign(locations_.begin() + begin, locations_.begin() + end);
+  slice.payloads_.assign(payloads_.begin() + begin, payloads_.begin() + end);
+
+  slice.types_.push_back(TokenType::kEOF);
+  slice.locations_.push_back(locations_[end]);
+  slice.payloads_.push_back(0);
+
+  return slice;
+}
+
+void TokenBuffer::ShiftOffsets(size_t index, int64_t delta) {
+  for (size_t i = index; i < locations_.size(); ++i) {
+    locations_[i].offset += delta;
+  }
+}
+
+size_t TokenBuffer::Size() const {
+  return types_.size();
+}
+
+TokenType TokenBuffer::Type(size_t index) const {
+  return types_[index];
+}
+
+Location TokenBuffer::GetLocation(size_t index) const {
+  return locations_[index];
+}
+
+size_t TokenBuffer::LowerBound(uint32_t offset) const {
+  auto it = std::lower_bound(locations_.begin(), locations_.end(), offset,  //
+                             [](Location location, uint32_t offset) {
+                               return location.offset < offset;
+                             });
+  return it - locations_.begin();
+}
+
+Token TokenBuffer::At(size_t index) const {
+  Token token{};
+  token.type = types_[index];
+  token.location = locations_[index];
+
+  switch (token.type) {
+    case TokenType::kNumber:
+      token.value.number = payloads_[index];
+      break;
+
+    case TokenType::kString:
+    case TokenType::kIdentifier:
+      token.value.identifier = Symbol::FromId(static_cast<SymbolId>(payloads_[index]));
+      break;
+
+    case TokenType::kError:
+      token.value.error = static_cast<errors::LexErrorCode>(payloads_[index]);
+      break;
+
+    default:
+      break;
+  }
+
+  return token;
+}
+
+void TokenBuffer::Reserve(size_t count) {
+  types_.reserve(count);
+  locations_.reserve(count);
+  payloads_.reserve(count);
+}
+
+////////////////////////////////////////////////////////////////////
+
+TokenCursor::TokenCursor(const TokenBuffer& buffer) : buffer_{&buffer} {
+  FMT_ASSERT(buffer.Size() > 0 && buffer.Type(buffer.Size() - 1) == TokenType::kEOF,
+             "Token buffer must end with EOF\n");
+}
+
+// Reading past the end keeps returning the trailing EOF
+
+Token TokenCursor::Peek() const {
+  return buffer_->At(std::min(position_, buffer_->Size() - 1));
+}
+
+TokenType TokenCursor::PeekType(size_t distance) const {
+  return buffer_->Type(std::min(position_ + distance, buffer_->Size() - 1));
+}
+
+Token TokenCursor::GetPreviousToken() const {
+  FMT_ASSERT(position_ > 0, "No previous token\n");
+  return buffer_->At(position_ - 1);
+}
+
+void TokenCursor::Advance() {
+  if (position_ < buffer_->Size()) {
+    ++position_;
+  }
+}
+
+bool TokenCursor::Matches(TokenType type) {
+  if (PeekType() != type) {
+    return false;
+  }
+
+  Advance();
+  return true;
+}
+
+TokenCursor::Mark TokenCursor::Save() const {
+  return position_;
+}
+
+void TokenCursor::Restore(Mark mark) {
+  position_ = mark;
+}
+
+}  // namespace lex
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <lex/token.hpp>
+
+#include <vector>
+
+namespace lex {
+
+//////////////////////////////////////////////////////////////////////
+
+// All tokens of a file, structure-of-arrays: scanning for a type
+// touches only the (dense) type array. The last token is always kEOF.
+
+class TokenBuffer {
+ public:
+  void Append(const Token& token);
+
+  // Appends the first `count` tokens of `other`
+  void Append(const TokenBuffer& other, size_t count);
+
+  // Replaces tokens [begin, end) with the first `count` tokens of `other`
+  void Replace(size_t begin, size_t end, const TokenBuffer& other, size_t count);
+
+  // Copy of tokens [begin, end) closed by a kEOF at the location of
+  // token `end`, so the copy can be parsed on its own
+  TokenBuffer Slice(size_t begin, size_t end) const;
+
+  // Moves tokens starting from `index` by `delta` bytes in the file
+  void ShiftOffsets(size_t index, int64_t delta);
+
+  size_t Size() const;
+
+  TokenType Type(size_t index) const;
+  Location GetLocation(size_t index) const;
+
+  // Index of the first token starting at `offset` or later
+  size_t LowerBound(uint32_t offset) const;
+
+  // Reassembles the token from the arrays
+  Token At(size_t index) const;
+
+  void Reserve(size_t count);
+
+ private:
+  std::vector<TokenType> types_;
+  std::vector<Location> locations_;
+
+  // Number or symbol id
+  std::vector<uint64_t> payloads_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// Position in a TokenBuffer with the same interface as the Lexer, but
+// any lookahead distance and free backtracking:
+//
+//   auto mark = cursor.Save();
+//   if (!TryParseSomething()) {
+//     cursor.Restore(mark);
+//   }
+
+class TokenCursor {
+ public:
+  explicit TokenCursor(const TokenBuffer& buffer);
+
+  Token Peek() const;
+  TokenType PeekType(size_t distance = 0) const;
+
+  Token GetPreviousToken() const;
+
+  void Advance();
+
+  // Check current token type and maybe consume it.
+  bool Matches(TokenType type);
+
+  using Mark = size_t;
+
+  Mark Save() const;
+  void Restore(Mark mark);
+
+ private:
+  const TokenBuffer* buffer_;
+  size_t position_{0};
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace lex
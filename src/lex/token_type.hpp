@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdlib>
+#include <cstdint>
 
 namespace lex {
 
@@ -41,12 +42,13 @@ enum class TokenType : uint32_t {
   kIdentifier,
 
   /* Other */
+  kError,  // Malformed token, see lex/lex_error.hpp
   kEOF
 };
 
 ////////////////////////////////////////////////////////////////
 
-inline const char* FormatTokenType(TokenType type) {
+constexpr const char* FormatTokenType(TokenType type) {
   switch (type) {
     case TokenType::kPlus:        { return "+"; }
     case TokenType::kMinus:       { return "-"; }
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <lex/token_type.hpp>
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+namespace parse {
+
+//////////////////////////////////////////////////////////////////////
+
+// Precedence table from tasks/03-parser.md, smaller binds tighter:
+//
+//   1  f()       call      left to right
+//   2  - !       unary     right to left
+//   3  * /                 left to right
+//   4  + -                 left to right
+//   5  < >                 left to right
+//   6  == !=               left to right
+
+enum Precedence : uint8_t {
+  kNotAnOperator = 0,
+
+  kPostfix = 1,
+  kUnary = 2,
+  kMultiplicative = 3,
+  kAdditive = 4,
+  kRelational = 5,
+  kEquality = 6,
+
+  // Closes every pending operator
+  kAny = 7,
+};
+
+struct OperatorInfo {
+  Precedence precedence = kNotAnOperator;
+  bool right_associative = false;
+
+  // Builds a ComparisonExpression instead of a BinaryExpression
+  bool comparison = false;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+constexpr auto MakeInfixTable() {
+  std::array<OperatorInfo, static_cast<size_t>(lex::TokenType::kEOF) + 1> table{};
+
+  auto set = [&table](lex::TokenType type, Precedence precedence, bool comparison = false) {
+    table[static_cast<size_t>(type)] = {precedence, false, comparison};
+  };
+
+  set(lex::TokenType::kStar, kMultiplicative);
+  set(lex::TokenType::kDiv, kMultiplicative);
+
+  set(lex::TokenType::kPlus, kAdditive);
+  set(lex::TokenType::kMinus, kAdditive);
+
+  set(lex::TokenType::kLess, kRelational, /*comparison=*/true);
+  set(lex::TokenType::kGreater, kRelational, /*comparison=*/true);
+
+  set(lex::TokenType::kEquals, kEquality, /*comparison=*/true);
+  set(lex::TokenType::kNotEq, kEquality, /*comparison=*/true);
+
+  return table;
+}
+
+inline constexpr auto kInfixTable = MakeInfixTable();
+
+}  // namespace detail
+
+//////////////////////////////////////////////////////////////////////
+
+constexpr OperatorInfo InfixOperator(lex::TokenType type) {
+  return detail::kInfixTable[static_cast<size_t>(type)];
+}
+
+constexpr bool IsPrefixOperator(lex::TokenType type) {
+  return type == lex::TokenType::kMinus || type == lex::TokenType::kNot;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace parse
@@ -0,0 +1,124 @@
+#include <parse/parallel_parser.hpp>
+
+#include <algorithm>
+#include <future>
+
+namespace parse {
+
+////////////////////////////////////////////////////////////////////
+
+std::vector<size_t> FindDeclarationBoundaries(const lex::TokenBuffer& tokens) {
+  std::vector<size_t> boundaries{0};
+
+  size_t eof = tokens.Size() - 1;
+
+  // Unbalanced closing brackets (a syntax error) do not push the depth
+  // below zero, the parser reports them at the top level
+  size_t depth = 0;
+
+  for (size_t i = 0; i < eof; ++i) {
+    switch (tokens.Type(i)) {
+      case lex::TokenType::kLeftParen:
+      case lex::TokenType::kLeftCBrace:
+        ++depth;
+        break;
+
+      case lex::TokenType::kRightParen:
+      case lex::TokenType::kRightCBrace:
+        depth -= (depth > 0);
+        break;
+
+      case lex::TokenType::kVar:
+      case lex::TokenType::kFun:
+        if (depth == 0 && i != 0) {
+          boundaries.push_back(i);
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  boundaries.push_back(eof);
+  return boundaries;
+}
+
+////////////////////////////////////////////////////////////////////
+
+namespace {
+
+struct TaskResult {
+  std::unique_ptr<Arena> arena;
+  std::vector<Declaration*> declarations;
+  errors::Diagnostics errors;
+};
+
+TaskResult ParseRange(const lex::TokenBuffer& tokens, size_t begin, size_t end) {
+  TaskResult result;
+  result.arena = std::make_unique<Arena>();
+
+  Parser parser{tokens.Slice(begin, end), *result.arena};
+  result.declarations = parser.ParseFile();
+
+  for (auto error : parser.GetErrors().All()) {
+    error.token_index += begin;
+    result.errors.Report(error);
+  }
+
+  return result;
+}
+
+}  // namespace
+
+////////////////////////////////////////////////////////////////////
+
+ParsedFile ParseParallel(const lex::TokenBuffer& tokens, util::ThreadPool& pool, ParallelMode mode) {
+  auto boundaries = FindDeclarationBoundaries(tokens);
+
+  // Group consecutive declarations into tasks of at least
+  // `min_task_tokens`, the last task takes the remainder
+  std::vector<size_t> splits{0};
+  for (size_t boundary : boundaries) {
+    if (boundary - splits.back() >= std::max<size_t>(mode.min_task_tokens, 1)) {
+      splits.push_back(boundary);
+    }
+  }
+  if (splits.back() != boundaries.back()) {
+    splits.push_back(boundaries.back());
+  }
+
+  std::vector<TaskResult> results;
+
+  if (splits.size() <= 2) {
+    results.push_back(ParseRange(tokens, splits.front(), splits.back()));
+  } else {
+    std::vector<std::future<TaskResult>> tasks;
+    for (size_t i = 0; i + 1 < splits.size(); ++i) {
+      tasks.push_back(pool.Submit([&tokens, begin = splits[i], end = splits[i + 1]] {
+        return ParseRange(tokens, begin, end);
+      }));
+    }
+
+    // Futures are drained in submission order, which is source order
+    for (auto& task : tasks) {
+      results.push_back(task.get());
+    }
+  }
+
+  ParsedFile file;
+  for (auto& result : results) {
+    file.arenas.push_back(std::move(result.arena));
+    file.declarations.insert(file.declarations.end(), result.declarations.begin(), result.declarations.end());
+
+    for (auto error : result.errors.All()) {
+      file.errors.Report(error);
+    }
+  }
+
+  return file;
+}
+
+////////////////////////////////////////////////////////////////////
+
+}  // namespace parse
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <parse/parser.hpp>
+
+#include <util/thread_pool.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace parse {
+
+//////////////////////////////////////////////////////////////////////
+
+struct ParallelMode {
+  // Declarations are handed to the pool in groups of about this many
+  // tokens, smaller files are parsed on the calling thread
+  size_t min_task_tokens = 16 * 1024;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// Token indices where top-level declarations start: a `var` or `fun`
+// outside of any parentheses or braces. The result starts with 0 and
+// ends with the index of the trailing kEOF.
+//
+// Only the dense type array of the buffer is scanned.
+
+std::vector<size_t> FindDeclarationBoundaries(const lex::TokenBuffer& tokens);
+
+//////////////////////////////////////////////////////////////////////
+
+struct ParsedFile {
+  // One arena per task, the declarations point into them
+  std::vector<std::unique_ptr<Arena>> arenas;
+
+  // In source order
+  std::vector<Declaration*> declarations;
+
+  // Token indices refer to the whole buffer
+  errors::Diagnostics errors;
+};
+
+// Parses groups of top-level declarations on the pool, each group with
+// its own Parser over a slice of `tokens` and its own arena, then joins
+// the results in source order. The outcome does not depend on the
+// scheduling; for a file without errors it is the same as the one of
+// Parser::ParseFile. A syntax error is recovered from inside its group.
+
+ParsedFile ParseParallel(const lex::TokenBuffer& tokens, util::ThreadPool& pool, ParallelMode mode = {});
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace parse
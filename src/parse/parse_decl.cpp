@@ -8,6 +8,37 @@ FunDeclStatement* Parser::ParseFunDeclarationStandalone() {
 
 ///////////////////////////////////////////////////////////////////
 
+std::vector<Declaration*> Parser::ParseFile() {
+  std::vector<Declaration*> declarations;
+
+  while (cursor_.PeekType() != lex::TokenType::kEOF) {
+    auto mark = cursor_.Save();
+
+    if (auto* declaration = ParseDeclaration()) {
+      declarations.push_back(declaration);
+      continue;
+    }
+
+    if (cursor_.Save() == mark) {
+      Error(parse::errors::ErrorCode::kExpectedDeclaration);
+    }
+
+    Synchronize();
+
+    // A stray `}` has nothing to close at the top level
+    while (Matches(lex::TokenType::kRightCBrace)) {
+    }
+
+    if (cursor_.Save() == mark) {
+      cursor_.Advance();  // Always make progress
+    }
+  }
+
+  return declarations;
+}
+
+///////////////////////////////////////////////////////////////////
+
 Declaration* Parser::ParseDeclaration() {
   if (auto var_declaration = ParseVarDeclStatement()) {
     return var_declaration;
@@ -22,17 +53,75 @@ Declaration* Parser::ParseDeclaration() {
 
 ///////////////////////////////////////////////////////////////////
 
+// <function-declaration> ::= fun <identifier> <parameter-list> = <expression> ;
+//
+// A body which is not a block is wrapped into one
+
 FunDeclStatement* Parser::ParseFunDeclStatement() {
+  if (!Matches(lex::TokenType::kFun)) {
+    return nullptr;
+  }
+
+  auto name = cursor_.Peek();
+  if (!Consume(lex::TokenType::kIdentifier)) {
+    return nullptr;
+  }
+
+  auto params = ParseFormals();
+
+  if (!Consume(lex::TokenType::kAssign)) {
+    return nullptr;
+  }
+
+  auto body_start = cursor_.Peek();
+
+  auto* body_expr = ParseExpression();
+  if (!body_expr || !Consume(lex::TokenType::kColon)) {
+    return nullptr;
+  }
+
+  auto* body = dyn_cast<BlockExpression>(body_expr);
+  if (!body) {
+    body = Make<BlockExpression>(body_start, std::vector<Statement*>{Make<ExprStatement>(body_expr)});
+  }
+
+  return Make<FunDeclStatement>(name, std::move(params), body);
 }
 
 ///////////////////////////////////////////////////////////////////
 
+// <parameter-list> ::= <identifier>*
+
 auto Parser::ParseFormals() -> std::vector<lex::Token> {
+  std::vector<lex::Token> params;
+
+  while (Matches(lex::TokenType::kIdentifier)) {
+    params.push_back(cursor_.GetPreviousToken());
+  }
+
+  return params;
 }
 
 ///////////////////////////////////////////////////////////////////
 
+// <variable-declaration> ::= var <identifier> = <expression> ;
+
 VarDeclStatement* Parser::ParseVarDeclStatement() {
+  if (!Matches(lex::TokenType::kVar)) {
+    return nullptr;
+  }
+
+  auto name = cursor_.Peek();
+  if (!Consume(lex::TokenType::kIdentifier) || !Consume(lex::TokenType::kAssign)) {
+    return nullptr;
+  }
+
+  auto* rhs = ParseExpression();
+  if (!rhs || !Consume(lex::TokenType::kColon)) {
+    return nullptr;
+  }
+
+  return Make<VarDeclStatement>(name, rhs);
 }
 
 ///////////////////////////////////////////////////////////////////
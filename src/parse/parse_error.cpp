@@ -0,0 +1,69 @@
+#include <parse/parse_error.hpp>
+
+namespace parse::errors {
+
+////////////////////////////////////////////////////////////////////
+
+// Tokens without a fixed spelling
+static std::string_view Describe(lex::TokenType type) {
+  switch (type) {
+    case lex::TokenType::kIdentifier:
+      return "identifier";
+    case lex::TokenType::kNumber:
+      return "number";
+    case lex::TokenType::kString:
+      return "string";
+    case lex::TokenType::kEOF:
+      return "end of file";
+    default:
+      return lex::FormatTokenType(type);
+  }
+}
+
+static std::string FormatLexError(lex::errors::LexErrorCode code, const std::string& location) {
+  switch (code) {
+    case lex::errors::LexErrorCode::kNumberOverflow:
+      return fmt::format("Numeric literal is out of the 64-bit range at location {}\n", location);
+
+    case lex::errors::LexErrorCode::kMissingDigits:
+      return fmt::format("Expected digits after the radix prefix at location {}\n", location);
+  }
+
+  FMT_ASSERT(false, "Unknown lex error code\n");
+}
+
+std::string Format(const ParseError& error, const lex::TokenBuffer& tokens) {
+  auto location = tokens.GetLocation(error.token_index).Format();
+
+  switch (error.code) {
+    case ErrorCode::kExpectedToken:
+      return fmt::format("Expected token {} at location {}\n",  //
+                         Describe(error.expected), location);
+
+    case ErrorCode::kExpectedPrimary:
+      return fmt::format("Could not match primary expression at location {}\n", location);
+
+    case ErrorCode::kExpectedLvalue:
+      return fmt::format("Expected lvalue at location {}\n", location);
+
+    case ErrorCode::kExpectedDeclaration:
+      return fmt::format("Expected declaration at location {}\n", location);
+
+    case ErrorCode::kLexError:
+      return FormatLexError(tokens.At(error.token_index).value.error, location);
+  }
+
+  FMT_ASSERT(false, "Unknown error code\n");
+}
+
+////////////////////////////////////////////////////////////////////
+
+std::string Diagnostics::Format(const lex::TokenBuffer& tokens) const {
+  std::string messages;
+  for (const auto& error : errors_) {
+    messages += errors::Format(error, tokens);
+  }
+  return messages;
+}
+
+}  // namespace parse::errors
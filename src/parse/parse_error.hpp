@@ -1,50 +1,72 @@
 #pragma once
 
+#include <lex/token_buffer.hpp>
+
 #include <fmt/core.h>
 
+#include <cstdint>
 #include <string>
+#include <vector>
+#include <span>
 
 namespace parse::errors {
 
-struct ParseError : std::exception {
-  std::string message;
+//////////////////////////////////////////////////////////////////////
 
-  const char* what() const noexcept override {
-    return message.c_str();
-  }
+enum class ErrorCode : uint8_t {
+  kExpectedToken,
+  kExpectedPrimary,
+  kExpectedLvalue,
+  kExpectedDeclaration,
+
+  // Malformed token, the lexer's code is in the token's value
+  kLexError,
 };
 
-struct ParsePrimaryError : ParseError {
-  ParsePrimaryError(const std::string& location) {
-    message = fmt::format("Could not match primary expression at location {}\n",
-                          location);
-  }
+// Plain record, nothing is formatted until somebody asks: reporting an
+// error costs a push_back. The location is the token the parser was
+// looking at, or the kError token for kLexError.
+
+struct ParseError {
+  ErrorCode code;
+
+  // kExpectedToken only
+  lex::TokenType expected = lex::TokenType::kEOF;
+
+  uint32_t token_index = 0;
 };
 
-struct ParseTrueBlockError : ParseError {
-  ParseTrueBlockError(const std::string& location) {
-    message =
-        fmt::format("Could not parse true block at location {}\n", location);
+std::string Format(const ParseError& error, const lex::TokenBuffer& tokens);
+
+//////////////////////////////////////////////////////////////////////
+
+// Errors of one parse, in the order they were found
+
+class Diagnostics {
+ public:
+  void Report(ParseError error) {
+    errors_.push_back(error);
   }
-};
 
-struct ParseNonLvalueError : ParseError {
-  ParseNonLvalueError(const std::string& location) {
-    message = fmt::format("Expected lvalue at location {}\n", location);
+  bool Empty() const {
+    return errors_.empty();
   }
-};
 
-struct ParseTypeError : ParseError {
-  ParseTypeError(const std::string& location) {
-    message =
-        fmt::format("Could not parse the type at location {}\n", location);
+  size_t Size() const {
+    return errors_.size();
   }
-};
 
-struct ParseTokenError : ParseError {
-  ParseTokenError(const std::string& tok, const std::string& location) {
-    message = fmt::format("Expected token {} at location {}\n", tok, location);
+  std::span<const ParseError> All() const {
+    return errors_;
   }
+
+  // One message per line
+  std::string Format(const lex::TokenBuffer& tokens) const;
+
+ private:
+  std::vector<ParseError> errors_;
 };
 
+//////////////////////////////////////////////////////////////////////
+
 }  // namespace parse::errors
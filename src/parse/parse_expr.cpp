@@ -14,21 +14,11 @@ Expression* Parser::ParseKeywordExpresssion() {
     return return_statement;
   }
 
-  if (auto yield_statement = ParseYieldStatement()) {
-    return yield_statement;
-  }
-
   if (auto if_expr = ParseIfExpression()) {
     return if_expr;
   }
 
-  if (auto match_expr = ParseMatchExpression()) {
-    return match_expr;
-  }
-
-  if (auto new_expr = ParseNewExpression()) {
-    return new_expr;
-  }
+  // yield, match and new have no tokens yet
 
   return nullptr;
 }
@@ -48,7 +38,32 @@ Expression* Parser::ParseAddressof() {
 ///////////////////////////////////////////////////////////////////
 
 Expression* Parser::ParseIfExpression() {
-  std::abort();  // Your code goes here
+  if (!Matches(lex::TokenType::kIf)) {
+    return nullptr;
+  }
+
+  auto if_token = cursor_.GetPreviousToken();
+
+  auto* condition = ParseExpression();
+  if (!condition) {
+    return nullptr;
+  }
+
+  Matches(lex::TokenType::kThen);  // optional
+
+  auto* true_expr = ParseExpression();
+  if (!true_expr) {
+    return nullptr;
+  }
+
+  Expression* false_expr = nullptr;
+  if (Matches(lex::TokenType::kElse)) {
+    if (false_expr = ParseExpression(); !false_expr) {
+      return nullptr;
+    }
+  }
+
+  return Make<IfExpression>(if_token, condition, true_expr, false_expr);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -65,26 +80,222 @@ Expression* Parser::ParseNewExpression() {
 
 ////////////////////////////////////////////////////////////////////
 
+// <compound-expression> ::= { (<declaration> | <statement>)* <expression>? }
+// The trailing expression is kept as the last ExprStatement
+
 Expression* Parser::ParseBlockExpression() {
-  std::abort();  // Your code goes here
+  if (!Matches(lex::TokenType::kLeftCBrace)) {
+    return nullptr;
+  }
+
+  auto open_brace = cursor_.GetPreviousToken();
+  std::vector<Statement*> statements;
+
+  while (!Matches(lex::TokenType::kRightCBrace)) {
+    if (cursor_.PeekType() == lex::TokenType::kEOF) {
+      return Error(parse::errors::ErrorCode::kExpectedToken, lex::TokenType::kRightCBrace);
+    }
+
+    auto mark = cursor_.Save();
+
+    bool declaration = cursor_.PeekType() == lex::TokenType::kVar ||  //
+                       cursor_.PeekType() == lex::TokenType::kFun;
+
+    if (auto* statement = declaration ? ParseDeclaration() : ParseStatement()) {
+      statements.push_back(statement);
+      continue;
+    }
+
+    Synchronize();
+
+    if (cursor_.Save() == mark) {
+      cursor_.Advance();  // Always make progress
+    }
+  }
+
+  return Make<BlockExpression>(open_brace, std::move(statements));
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Expression* Parser::ParseComparison() {
-  std::abort();  // Your code goes here
+  return ParseOperators(parse::kEquality);
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Expression* Parser::ParseBinary() {
-  std::abort();  // Your code goes here
+  return ParseOperators(parse::kAdditive);
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Expression* Parser::ParseUnary() {
-  std::abort();  // Your code goes here
+  return ParseOperators(parse::kUnary);
+}
+
+////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Pending operator or open bracket of ParseOperators
+struct Frame {
+  enum Kind : uint8_t {
+    kPrefix,
+    kInfix,
+    kGroup,
+    kCall,
+  };
+
+  Kind kind;
+  lex::Token token;
+
+  // kCall: arguments are the operands above this height
+  size_t operands = 0;
+
+  // Brackets are barriers: operators are never applied across them
+  parse::Precedence GetPrecedence() const {
+    switch (kind) {
+      case kPrefix:
+        return parse::kUnary;
+      case kInfix:
+        return parse::InfixOperator(token.type).precedence;
+      default:
+        return parse::kNotAnOperator;
+    }
+  }
+};
+
+}  // namespace
+
+Expression* Parser::ParseOperators(parse::Precedence loosest) {
+  std::vector<Expression*> operands;
+  std::vector<Frame> frames;
+  size_t open_brackets = 0;
+
+  auto apply_top = [&] {
+    Frame frame = frames.back();
+    frames.pop_back();
+
+    Expression* rhs = operands.back();
+
+    if (frame.kind == Frame::kPrefix) {
+      operands.back() = Make<UnaryExpression>(frame.token, rhs);
+      return;
+    }
+
+    operands.pop_back();
+    Expression* lhs = operands.back();
+
+    if (parse::InfixOperator(frame.token.type).comparison) {
+      operands.back() = Make<ComparisonExpression>(frame.token, lhs, rhs);
+    } else {
+      operands.back() = Make<BinaryExpression>(frame.token, lhs, rhs);
+    }
+  };
+
+  // Applies the pending operators which bind tighter than an incoming
+  // one of the given precedence (or as tight, if it is left-associative)
+  auto apply_while = [&](parse::Precedence precedence, bool right_associative) {
+    while (!frames.empty()) {
+      auto top = frames.back().GetPrecedence();
+
+      if (top == parse::kNotAnOperator || top > precedence || (top == precedence && right_associative)) {
+        break;
+      }
+
+      apply_top();
+    }
+  };
+
+  bool expect_operand = true;
+
+  while (true) {
+    // Inside brackets the full grammar is allowed again
+    auto allowed = (open_brackets > 0) ? parse::kEquality : loosest;
+    auto token = cursor_.Peek();
+
+    if (expect_operand) {
+      if (parse::IsPrefixOperator(token.type) && allowed >= parse::kUnary) {
+        cursor_.Advance();
+        frames.push_back({Frame::kPrefix, token});
+        continue;
+      }
+
+      if (token.type == lex::TokenType::kLeftParen) {
+        cursor_.Advance();
+        frames.push_back({Frame::kGroup, token});
+        ++open_brackets;
+        continue;
+      }
+
+      bool call = token.type == lex::TokenType::kIdentifier &&  //
+                  cursor_.PeekType(1) == lex::TokenType::kLeftParen && allowed >= parse::kPostfix;
+
+      if (call) {
+        cursor_.Advance();
+        cursor_.Advance();
+
+        if (!Matches(lex::TokenType::kRightParen)) {
+          frames.push_back({Frame::kCall, token, operands.size()});
+          ++open_brackets;
+          continue;
+        }
+
+        operands.push_back(Make<FnCallExpression>(token, std::vector<Expression*>{}));
+      } else if (auto* primary = ParsePrimary()) {
+        operands.push_back(primary);
+      } else {
+        return nullptr;
+      }
+
+      expect_operand = false;
+      continue;
+    }
+
+    auto info = parse::InfixOperator(token.type);
+
+    if (info.precedence != parse::kNotAnOperator && info.precedence <= allowed) {
+      apply_while(info.precedence, info.right_associative);
+
+      cursor_.Advance();
+      frames.push_back({Frame::kInfix, token});
+
+      expect_operand = true;
+      continue;
+    }
+
+    if (open_brackets == 0) {
+      break;  // The token belongs to the enclosing construct
+    }
+
+    apply_while(parse::kAny, false);
+    Frame& bracket = frames.back();
+
+    if (token.type == lex::TokenType::kComma && bracket.kind == Frame::kCall) {
+      cursor_.Advance();
+      expect_operand = true;
+      continue;
+    }
+
+    if (!Consume(lex::TokenType::kRightParen)) {
+      return nullptr;
+    }
+
+    if (bracket.kind == Frame::kCall) {
+      std::vector<Expression*> args(operands.begin() + bracket.operands, operands.end());
+      operands.resize(bracket.operands);
+      operands.push_back(Make<FnCallExpression>(bracket.token, std::move(args)));
+    }
+
+    frames.pop_back();
+    --open_brackets;
+  }
+
+  apply_while(parse::kAny, false);
+  FMT_ASSERT(operands.size() == 1 && frames.empty(), "Unbalanced operator stack\n");
+
+  return operands.back();
 }
 
 ///////////////////////////////////////////////////////////////////
@@ -119,7 +330,7 @@ Expression* Parser::ParseFnCallUnnamed(Expression* expr) {
 ////////////////////////////////////////////////////////////////////
 
 Expression* Parser::ParsePostfixExpressions() {
-  std::abort();  // Your code goes here
+  return ParseOperators(parse::kPostfix);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -127,17 +338,47 @@ Expression* Parser::ParsePostfixExpressions() {
 Expression* Parser::ParsePrimary() {
   // Try parsing grouping first
 
-  // > Your code goes here
+  if (Matches(lex::TokenType::kLeftParen)) {
+    auto* expr = ParseExpression();
+    if (!expr || !Consume(lex::TokenType::kRightParen)) {
+      return nullptr;
+    }
+    return expr;
+  }
 
   // Then keyword expressions
 
-  // > Your code goes here
+  if (auto* keyword_expr = ParseKeywordExpresssion()) {
+    return keyword_expr;
+  }
+
+  if (cursor_.PeekType() == lex::TokenType::kLeftCBrace) {
+    return ParseBlockExpression();
+  }
 
   // Then all the base cases: IDENT, INT, TRUE, FALSE, ETC...
 
-  // > Your code goes here
+  auto token = cursor_.Peek();
+
+  switch (token.type) {
+    case lex::TokenType::kIdentifier:
+      cursor_.Advance();
+      return Make<VarAccessExpression>(token);
 
-  FMT_ASSERT(false, "Unreachable!");
+    case lex::TokenType::kNumber:
+    case lex::TokenType::kString:
+    case lex::TokenType::kTrue:
+    case lex::TokenType::kFalse:
+      cursor_.Advance();
+      return Make<LiteralExpression>(token);
+
+    case lex::TokenType::kError:
+      cursor_.Advance();
+      return nullptr;  // Reported by ReportLexErrors
+
+    default:
+      return Error(parse::errors::ErrorCode::kExpectedPrimary);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -156,7 +397,18 @@ Expression* Parser::ParseSignleFieldCompound() {
 ////////////////////////////////////////////////////////////////////
 
 Expression* Parser::ParseReturnStatement() {
-  std::abort();
+  if (!Matches(lex::TokenType::kReturn)) {
+    return nullptr;
+  }
+
+  auto return_token = cursor_.GetPreviousToken();
+
+  auto* expr = ParseExpression();
+  if (!expr) {
+    return nullptr;
+  }
+
+  return Make<ReturnExpression>(return_token, expr);
 }
 
 ///////////////////////////////////////////////////////////////////
@@ -4,9 +4,58 @@
 ///////////////////////////////////////////////////////////////////
 
 Statement* Parser::ParseStatement() {
-  // Your code goes here
+  return ParseExprStatement();
+}
+
+///////////////////////////////////////////////////////////////////
+
+// <expression-statement> ::= <expression> ;
+// <assignment-statement> ::= <unary-expression> = <expression> ;
+//
+// The `;` may be omitted before the `}` closing a block: the last
+// expression is the value of the block
+
+Statement* Parser::ParseExprStatement() {
+  auto* expr = ParseExpression();
+  if (!expr) {
+    return nullptr;
+  }
+
+  if (cursor_.PeekType() == lex::TokenType::kAssign) {
+    auto* target = dyn_cast<LvalueExpression>(expr);
+    if (!target) {
+      return Error(parse::errors::ErrorCode::kExpectedLvalue);
+    }
+
+    return ParseAssignment(target);
+  }
+
+  if (cursor_.PeekType() != lex::TokenType::kRightCBrace && !Consume(lex::TokenType::kColon)) {
+    return nullptr;
+  }
+
+  return Make<ExprStatement>(expr);
+}
+
+///////////////////////////////////////////////////////////////////
+
+AssignmentStatement* Parser::ParseAssignment(LvalueExpression* target) {
+  if (!Consume(lex::TokenType::kAssign)) {
+    return nullptr;
+  }
+
+  auto assign_token = cursor_.GetPreviousToken();
+
+  auto* value = ParseExpression();
+  if (!value) {
+    return nullptr;
+  }
+
+  if (cursor_.PeekType() != lex::TokenType::kRightCBrace && !Consume(lex::TokenType::kColon)) {
+    return nullptr;
+  }
 
-  return nullptr;
+  return Make<AssignmentStatement>(assign_token, target, value);
 }
 
 ///////////////////////////////////////////////////////////////////
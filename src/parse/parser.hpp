@@ -1,15 +1,53 @@
 #pragma once
 
+#include <ast/structural_hash.hpp>
 #include <ast/declarations.hpp>
+#include <ast/arena.hpp>
+
+#include <parse/operators.hpp>
+#include <parse/parse_error.hpp>
 
 #include <lex/lexer.hpp>
 
 class Parser {
  public:
+  // Tokenizes the rest of the input up front. The nodes live in an
+  // arena owned by the parser, they are freed together with it.
   Parser(lex::Lexer& l);
 
+  Parser(lex::TokenBuffer tokens);
+
+  // Nodes are allocated in the arena of the compilation unit and
+  // outlive the parser
+  Parser(lex::Lexer& l, Arena& arena);
+
+  Parser(lex::TokenBuffer tokens, Arena& arena);
+
+  // The cursor points into the own token buffer
+  Parser(const Parser&) = delete;
+  Parser& operator=(const Parser&) = delete;
+
+  ///////////////////////////////////////////////////////////////////
+
+  // Syntax errors do not stop the parser: they are recorded, the parser
+  // skips to the next `;` or `}` and goes on. Functions return nullptr
+  // for the constructs they could not parse.
+
+  const parse::errors::Diagnostics& GetErrors() const;
+
+  // Messages for all errors, one per line
+  std::string FormatErrors() const;
+
+  // Structurally equal pure expressions of everything parsed from now
+  // on become one shared node, see HashConser. The result is a DAG.
+  void EnableHashConsing();
+
+  const HashConser* GetConser() const;
+
   ///////////////////////////////////////////////////////////////////
 
+  // <file> ::= <declaration>*
+  std::vector<Declaration*> ParseFile();
 
   ///////////////////////////////////////////////////////////////////
 
@@ -66,15 +104,53 @@ class Parser {
   ////////////////////////////////////////////////////////////////////
 
  private:
-  std::string FormatLocation();
+  // Operator-precedence core of the Parse*Expression functions: binary
+  // operators up to `loosest`, prefix operators and calls (if allowed),
+  // any operators inside parentheses. Pending operators and brackets
+  // live on explicit stacks, so nesting does not consume C++ stack.
+  Expression* ParseOperators(parse::Precedence loosest);
+
+  // Every node of the tree is created through this
+  template <typename Node, typename... Args>
+  Node* Make(Args&&... args) {
+    if constexpr (std::is_base_of_v<Expression, Node>) {
+      if (conser_ != nullptr) {
+        return conser_->Share(Node(std::forward<Args>(args)...), *arena_);
+      }
+    }
+    return arena_->Make<Node>(std::forward<Args>(args)...);
+  }
+
+  // Records an error at the current token, `return Error(...)` gives
+  // back nullptr of whatever type the function returns
+  std::nullptr_t Error(parse::errors::ErrorCode code, lex::TokenType expected = lex::TokenType::kEOF);
+
+  // The lexer's kError tokens, reported up front: the parser itself
+  // treats them as primaries it could not parse and does not report
+  // them again
+  void ReportLexErrors();
+
+  // Panic mode: skip past the next `;`, or up to the `}` closing the
+  // current block, or up to the next declaration
+  void Synchronize();
 
   auto ParseCSV() -> std::vector<Expression*>;
   auto ParseFormals() -> std::vector<lex::Token>;
 
   bool Matches(lex::TokenType type);
-  void Consume(lex::TokenType type);
+
+  // Reports kExpectedToken on mismatch
+  [[nodiscard]] bool Consume(lex::TokenType type);
   bool MatchesComparisonSign(lex::TokenType type);
 
  private:
-  lex::Lexer& lexer_;
+  lex::TokenBuffer tokens_;
+  lex::TokenCursor cursor_;
+
+  std::unique_ptr<Arena> owned_arena_;
+  Arena* arena_;
+
+  parse::errors::Diagnostics errors_;
+
+  std::unique_ptr<HashConser> conser_;
 };
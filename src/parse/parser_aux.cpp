@@ -1,6 +1,117 @@
 #include <parse/parse_error.hpp>
 #include <parse/parser.hpp>
 
-Parser::Parser(lex::Lexer& l) : lexer_{l} {
+Parser::Parser(lex::Lexer& l) : Parser(l.TokenizeAll()) {
 }
 
+Parser::Parser(lex::TokenBuffer tokens)
+    : tokens_{std::move(tokens)},
+      cursor_{tokens_},
+      owned_arena_{std::make_unique<Arena>()},
+      arena_{owned_arena_.get()} {
+  ReportLexErrors();
+}
+
+Parser::Parser(lex::Lexer& l, Arena& arena) : Parser(l.TokenizeAll(), arena) {
+}
+
+Parser::Parser(lex::TokenBuffer tokens, Arena& arena)
+    : tokens_{std::move(tokens)}, cursor_{tokens_}, arena_{&arena} {
+  ReportLexErrors();
+}
+
+///////////////////////////////////////////////////////////////////
+
+const parse::errors::Diagnostics& Parser::GetErrors() const {
+  return errors_;
+}
+
+std::string Parser::FormatErrors() const {
+  return errors_.Format(tokens_);
+}
+
+void Parser::EnableHashConsing() {
+  if (conser_ == nullptr) {
+    conser_ = std::make_unique<HashConser>();
+  }
+}
+
+const HashConser* Parser::GetConser() const {
+  return conser_.get();
+}
+
+///////////////////////////////////////////////////////////////////
+
+std::nullptr_t Parser::Error(parse::errors::ErrorCode code, lex::TokenType expected) {
+  errors_.Report({code, expected, static_cast<uint32_t>(cursor_.Save())});
+  return nullptr;
+}
+
+void Parser::ReportLexErrors() {
+  for (size_t i = 0; i < tokens_.Size(); ++i) {
+    if (tokens_.Type(i) == lex::TokenType::kError) {
+      errors_.Report({parse::errors::ErrorCode::kLexError, lex::TokenType::kEOF, static_cast<uint32_t>(i)});
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////
+
+void Parser::Synchronize() {
+  size_t depth = 0;
+
+  while (true) {
+    switch (cursor_.PeekType()) {
+      case lex::TokenType::kEOF:
+        return;
+
+      case lex::TokenType::kColon:
+        cursor_.Advance();
+        if (depth == 0) {
+          return;
+        }
+        break;
+
+      case lex::TokenType::kLeftCBrace:
+        ++depth;
+        cursor_.Advance();
+        break;
+
+      case lex::TokenType::kRightCBrace:
+        if (depth == 0) {
+          return;  // Closes the enclosing block
+        }
+        --depth;
+        cursor_.Advance();
+        break;
+
+      case lex::TokenType::kVar:
+      case lex::TokenType::kFun:
+        if (depth == 0) {
+          return;
+        }
+        cursor_.Advance();
+        break;
+
+      default:
+        cursor_.Advance();
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////
+
+bool Parser::Matches(lex::TokenType type) {
+  return cursor_.Matches(type);
+}
+
+///////////////////////////////////////////////////////////////////
+
+bool Parser::Consume(lex::TokenType type) {
+  if (!Matches(type)) {
+    Error(parse::errors::ErrorCode::kExpectedToken, type);
+    return false;
+  }
+
+  return true;
+}
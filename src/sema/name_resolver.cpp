@@ -0,0 +1,119 @@
+#include <sema/name_resolver.hpp>
+
+#include <ast/visitors/walker.hpp>
+
+namespace sema {
+
+//////////////////////////////////////////////////////////////////////
+
+namespace {
+
+class NameResolver : public Walker<NameResolver> {
+ public:
+  explicit NameResolver(NameErrors& errors) : errors_{errors} {
+  }
+
+  void DeclareGlobal(Declaration* declaration) {
+    if (auto* fun = dyn_cast<FunDeclStatement>(declaration)) {
+      Declare(fun->name, {SymbolKind::kFunction, fun});
+    } else if (auto* var = dyn_cast<VarDeclStatement>(declaration)) {
+      Declare(var->name, {SymbolKind::kVariable, var});
+    }
+  }
+
+  bool Enter(TreeNode* node) {
+    switch (node->GetKind()) {
+      case NodeKind::kFunDecl: {
+        auto* fun = static_cast<FunDeclStatement*>(node);
+
+        // Globals are declared up front; a local function is visible in
+        // its own body (recursion) and the rest of its block
+        if (table_.Depth() > 0) {
+          Declare(fun->name, {SymbolKind::kFunction, fun});
+        }
+
+        table_.Enter();
+        for (const auto& param : fun->params) {
+          Declare(param, {SymbolKind::kParameter, fun});
+        }
+        break;
+      }
+
+      case NodeKind::kBlock:
+        table_.Enter();
+        break;
+
+      case NodeKind::kVarAccess:
+        Use(static_cast<VarAccessExpression*>(node)->variable);
+        break;
+
+      case NodeKind::kFnCall:
+        Use(static_cast<FnCallExpression*>(node)->name);
+        break;
+
+      default:
+        break;
+    }
+    return true;
+  }
+
+  void Leave(TreeNode* node) {
+    switch (node->GetKind()) {
+      case NodeKind::kFunDecl:
+      case NodeKind::kBlock:
+        table_.Exit();
+        break;
+
+      case NodeKind::kVarDecl:
+        // Globals are declared up front
+        if (table_.Depth() > 0) {
+          auto* var = static_cast<VarDeclStatement*>(node);
+          Declare(var->name, {SymbolKind::kVariable, var});
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+
+ private:
+  void Declare(const lex::Token& name, SymbolInfo info) {
+    if (!table_.Bind(name.value.identifier, info)) {
+      errors_.redeclared.push_back(name);
+    }
+  }
+
+  void Use(const lex::Token& name) {
+    if (table_.Lookup(name.value.identifier) == nullptr) {
+      errors_.unbound.push_back(name);
+    }
+  }
+
+ private:
+  SymbolTable table_;
+  NameErrors& errors_;
+};
+
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+NameErrors ResolveNames(std::span<Declaration* const> file) {
+  NameErrors errors;
+  NameResolver resolver{errors};
+
+  for (auto* declaration : file) {
+    resolver.DeclareGlobal(declaration);
+  }
+
+  for (auto* declaration : file) {
+    resolver.Walk(declaration);
+  }
+
+  return errors;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace sema
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <sema/symbol_table.hpp>
+
+#include <ast/declarations.hpp>
+
+#include <span>
+#include <vector>
+
+namespace sema {
+
+//////////////////////////////////////////////////////////////////////
+
+// Scoping rules of the language over a SymbolTable: top-level
+// functions and variables are visible everywhere (mutual recursion),
+// a function body sees its parameters, a `var` is visible from the
+// next statement of its block on (so `var x = x + 1` reads the outer
+// `x`), a `fun` inside a block from its own body on.
+
+struct NameErrors {
+  // Variables and functions used but not declared
+  std::vector<lex::Token> unbound;
+
+  // Second declaration of a name in one scope
+  std::vector<lex::Token> redeclared;
+
+  bool Empty() const {
+    return unbound.empty() && redeclared.empty();
+  }
+};
+
+NameErrors ResolveNames(std::span<Declaration* const> file);
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace sema
@@ -0,0 +1,131 @@
+#include <sema/symbol_table.hpp>
+
+#include <fmt/core.h>
+
+#include <utility>
+
+namespace sema {
+
+//////////////////////////////////////////////////////////////////////
+
+// Ids are dense, multiplying spreads neighbours over the table
+static size_t Home(lex::SymbolId name, size_t mask) {
+  return ((uint64_t{name} * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+SymbolTable::SymbolTable() : slots_(kInitialSlots) {
+}
+
+void SymbolTable::Enter() {
+  scope_starts_.push_back(static_cast<uint32_t>(bindings_.size()));
+}
+
+void SymbolTable::Exit() {
+  FMT_ASSERT(!scope_starts_.empty(), "Error: exiting the global scope\n");
+
+  size_t start = scope_starts_.back();
+  scope_starts_.pop_back();
+
+  while (bindings_.size() > start) {
+    const Binding& binding = bindings_.back();
+    Probe(binding.name).top = binding.shadowed;
+    bindings_.pop_back();
+  }
+}
+
+bool SymbolTable::Bind(lex::Symbol name, SymbolInfo info) {
+  FMT_ASSERT(name.id != kNone, "Error: symbol id out of range\n");
+
+  info.depth = Depth();
+
+  Slot& slot = Probe(name.id);
+  bool fresh = slot.top == kNone || slot.top < ScopeStart();
+
+  bindings_.push_back({info, name.id, slot.top});
+  slot.top = static_cast<uint32_t>(bindings_.size() - 1);
+
+  return fresh;
+}
+
+const SymbolInfo* SymbolTable::Lookup(lex::Symbol name) const {
+  const Slot* slot = Find(name.id);
+  if (slot == nullptr || slot->top == kNone) {
+    return nullptr;
+  }
+  return &bindings_[slot->top].info;
+}
+
+uint32_t SymbolTable::Depth() const {
+  return static_cast<uint32_t>(scope_starts_.size());
+}
+
+size_t SymbolTable::Size() const {
+  return bindings_.size();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+size_t SymbolTable::ScopeStart() const {
+  return scope_starts_.empty() ? 0 : scope_starts_.back();
+}
+
+SymbolTable::Slot& SymbolTable::Probe(lex::SymbolId name) {
+  size_t mask = slots_.size() - 1;
+  for (size_t i = Home(name, mask);; i = (i + 1) & mask) {
+    Slot& slot = slots_[i];
+
+    if (slot.name == name) {
+      return slot;
+    }
+
+    if (slot.name == kNone) {
+      // At most half full
+      if (2 * (used_slots_ + 1) > slots_.size()) {
+        Grow();
+        return Probe(name);
+      }
+
+      slot.name = name;
+      ++used_slots_;
+      return slot;
+    }
+  }
+}
+
+const SymbolTable::Slot* SymbolTable::Find(lex::SymbolId name) const {
+  size_t mask = slots_.size() - 1;
+  for (size_t i = Home(name, mask);; i = (i + 1) & mask) {
+    const Slot& slot = slots_[i];
+
+    if (slot.name == name) {
+      return &slot;
+    }
+
+    if (slot.name == kNone) {
+      return nullptr;
+    }
+  }
+}
+
+void SymbolTable::Grow() {
+  std::vector<Slot> old = std::exchange(slots_, std::vector<Slot>(2 * slots_.size()));
+
+  size_t mask = slots_.size() - 1;
+  for (const Slot& slot : old) {
+    if (slot.name == kNone) {
+      continue;
+    }
+
+    size_t i = Home(slot.name, mask);
+    while (slots_[i].name != kNone) {
+      i = (i + 1) & mask;
+    }
+    slots_[i] = slot;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace sema
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <ast/syntax_tree.hpp>
+
+#include <lex/interner.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace sema {
+
+//////////////////////////////////////////////////////////////////////
+
+enum class SymbolKind : uint8_t {
+  kVariable,
+  kParameter,
+  kFunction,
+};
+
+struct SymbolInfo {
+  SymbolKind kind;
+
+  // VarDecl or FunDecl; for a parameter, its function
+  TreeNode* declaration;
+
+  // Scope depth of the binding, set by Bind: 0 is the global scope
+  uint32_t depth{0};
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// Scoped symbol table, see tasks/04-symbol-tables.md. Instead of a map
+// per scope and a walk up the parent chain, all scopes share one flat
+// open-addressing map from the interned name to the innermost binding.
+// Each binding remembers the one it shadows, and the bindings form a
+// stack which doubles as the undo log: Exit pops the bindings of the
+// scope and puts back what they shadowed.
+//
+// Lookup, Bind, Enter and Exit are O(1) amortized whatever the depth.
+//
+//   table.Enter();
+//   table.Bind(name, {SymbolKind::kVariable, var_decl});
+//   ... table.Lookup(name) ...
+//   table.Exit();
+
+class SymbolTable {
+ public:
+  SymbolTable();
+
+  // Opens a nested scope
+  void Enter();
+
+  // Drops the bindings of the innermost scope, the global one stays
+  void Exit();
+
+  // Binds `name` in the innermost scope, shadowing outer bindings.
+  // Returns false if this scope binds `name` already: the new binding
+  // shadows that one too, reporting is up to the caller.
+  bool Bind(lex::Symbol name, SymbolInfo info);
+
+  // Innermost binding of `name` or nullptr. The pointer is valid until
+  // the next Bind or Exit.
+  const SymbolInfo* Lookup(lex::Symbol name) const;
+
+  // Number of open scopes, 0 is the global scope
+  uint32_t Depth() const;
+
+  // Bindings visible or shadowed right now
+  size_t Size() const;
+
+ private:
+  static constexpr uint32_t kNone = UINT32_MAX;
+  static constexpr size_t kInitialSlots = 64;
+
+  struct Binding {
+    SymbolInfo info;
+    lex::SymbolId name;
+
+    // The binding this one shadows, or kNone
+    uint32_t shadowed;
+  };
+
+  // Names stay in the map once seen (with top == kNone while unbound),
+  // so there are no tombstones; the map grows with distinct names only
+  struct Slot {
+    lex::SymbolId name{kNone};
+    uint32_t top{kNone};
+  };
+
+  // bindings_ index where the innermost scope starts
+  size_t ScopeStart() const;
+
+  // Slot of `name`, claimed if the name is new
+  Slot& Probe(lex::SymbolId name);
+  const Slot* Find(lex::SymbolId name) const;
+
+  void Grow();
+
+ private:
+  std::vector<Slot> slots_;
+  size_t used_slots_{0};
+
+  // Stack of bindings, innermost scope last
+  std::vector<Binding> bindings_;
+
+  // bindings_.size() at every Enter
+  std::vector<uint32_t> scope_starts_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace sema
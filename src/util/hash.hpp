@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string_view>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace util {
+
+//////////////////////////////////////////////////////////////////////
+
+// Fast non-cryptographic hashing (the wyhash construction: one 64x64
+// -> 128 bit multiply per 16 bytes). Good for content addressing and
+// hash tables, useless against an adversary.
+
+inline uint64_t Mix(uint64_t a, uint64_t b) {
+  __uint128_t product = static_cast<__uint128_t>(a) * b;
+  return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+}
+
+inline constexpr uint64_t kHashPrimes[] = {
+    0xa0761d6478bd642full,
+    0xe7037ed1a0b428dbull,
+    0x8ebc6af09c88c6e3ull,
+};
+
+inline uint64_t HashBytes(std::string_view bytes, uint64_t seed = 0) {
+  const char* cur = bytes.data();
+  size_t left = bytes.size();
+
+  uint64_t state = seed ^ kHashPrimes[0];
+
+  for (; left > 16; cur += 16, left -= 16) {
+    uint64_t a = 0;
+    uint64_t b = 0;
+    std::memcpy(&a, cur, 8);
+    std::memcpy(&b, cur + 8, 8);
+    state = Mix(a ^ kHashPrimes[1], b ^ state);
+  }
+
+  uint64_t a = 0;
+  uint64_t b = 0;
+  if (left > 0) {
+    std::memcpy(&a, cur, std::min<size_t>(left, 8));
+  }
+  if (left > 8) {
+    std::memcpy(&b, cur + 8, left - 8);
+  }
+
+  return Mix(kHashPrimes[1] ^ bytes.size(), Mix(a ^ kHashPrimes[2], b ^ state));
+}
+
+// Order-dependent combination of two hashes
+inline uint64_t HashCombine(uint64_t seed, uint64_t value) {
+  return Mix(seed ^ kHashPrimes[0], value ^ kHashPrimes[1]);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace util
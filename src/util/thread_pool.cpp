@@ -0,0 +1,78 @@
+#include <util/thread_pool.hpp>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+
+namespace util {
+
+////////////////////////////////////////////////////////////////////
+
+ThreadPool::ThreadPool(size_t threads) {
+  FMT_ASSERT(threads > 0, "Thread pool needs at least one worker\n");
+
+  workers_.reserve(threads);
+  for (size_t i = 0; i < threads; ++i) {
+    workers_.emplace_back([this] {
+      Work();
+    });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard guard{mutex_};
+    stopping_ = true;
+  }
+  has_work_.notify_all();
+
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+
+size_t ThreadPool::Threads() const {
+  return workers_.size();
+}
+
+size_t ThreadPool::DefaultThreads() {
+  // May be 0 when the number is not computable
+  return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void ThreadPool::Push(std::function<void()> task) {
+  {
+    std::lock_guard guard{mutex_};
+    FMT_ASSERT(!stopping_, "Submit to a stopped thread pool\n");
+    tasks_.push_back(std::move(task));
+  }
+  has_work_.notify_one();
+}
+
+void ThreadPool::Work() {
+  while (true) {
+    std::function<void()> task;
+
+    {
+      std::unique_lock lock{mutex_};
+      has_work_.wait(lock, [this] {
+        return stopping_ || !tasks_.empty();
+      });
+
+      if (tasks_.empty()) {
+        return;  // Stopping and drained
+      }
+
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+
+    task();
+  }
+}
+
+}  // namespace util
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <condition_variable>
+#include <type_traits>
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+namespace util {
+
+//////////////////////////////////////////////////////////////////////
+
+// Fixed set of worker threads sharing one FIFO queue. Tasks are meant
+// to be coarse (a chunk of a file, a top-level declaration), so a
+// single mutex is not a bottleneck.
+//
+// Exceptions thrown by a task are rethrown from the future's `get()`.
+
+class ThreadPool {
+ public:
+  explicit ThreadPool(size_t threads = DefaultThreads());
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Finishes the queued tasks, then joins the workers
+  ~ThreadPool();
+
+  template <typename F>
+  auto Submit(F task) -> std::future<std::invoke_result_t<F>> {
+    using Result = std::invoke_result_t<F>;
+
+    // std::function wants a copyable callable
+    auto packaged = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+    auto future = packaged->get_future();
+
+    Push([packaged] {
+      (*packaged)();
+    });
+
+    return future;
+  }
+
+  size_t Threads() const;
+
+  static size_t DefaultThreads();
+
+ private:
+  void Push(std::function<void()> task);
+
+  void Work();
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable has_work_;
+  std::deque<std::function<void()>> tasks_;
+  bool stopping_{false};
+
+  std::vector<std::thread> workers_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+}  // namespace util
@@ -1,11 +1,43 @@
 #include <lex/lexer.hpp>
+#include <lex/scan_kernels.hpp>
+#include <lex/dfa.hpp>
+#include <lex/parallel_lexer.hpp>
+#include <lex/lex_error.hpp>
+#include <lex/incremental.hpp>
 #include <ast/visitors/print_visitor.hpp>
+#include <ast/visitors/static_visitor.hpp>
+#include <ast/visitors/walker.hpp>
+#include <ast/visitors/fused_walker.hpp>
+#include <ast/arena.hpp>
+#include <ast/flat_tree.hpp>
+#include <ast/dumper.hpp>
+#include <ast/serialize.hpp>
+#include <ast/structural_hash.hpp>
+#include <parse/parser.hpp>
+#include <parse/parse_error.hpp>
+#include <parse/parallel_parser.hpp>
+#include <cache/artifact_cache.hpp>
+#include <cache/cached_parse.hpp>
+#include <sema/symbol_table.hpp>
+#include <sema/name_resolver.hpp>
+#include <util/hash.hpp>
 
 // Finally,
 #include <catch2/catch_test_macros.hpp>
 
+#include <fmt/ranges.h>
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <chrono>
+#include <fstream>
+#include <future>
 #include <iostream>
 #include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unistd.h>
 
 //////////////////////////////////////////////////////////////////////
 
@@ -53,6 +85,20 @@ TEST_CASE("Keywords", "[lex]") {
 
 //////////////////////////////////////////////////////////////////////
 
+TEST_CASE("Ident table", "[lex]") {
+  static_assert(lex::IdentTable::LookupWord("return") == lex::TokenType::kReturn);
+
+  for (auto type : lex::kKeywords) {
+    CHECK(lex::IdentTable::LookupWord(lex::FormatTokenType(type)) == type);
+  }
+
+  for (auto word : {"", "a", "iff", "Fun", "ret", "returns", "thenn", "els", "xor", "_var"}) {
+    CHECK_FALSE(lex::IdentTable::LookupWord(word).has_value());
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
 TEST_CASE("Consequent", "[lex]") {
   std::stringstream source("!true");
   lex::Lexer l{source};
@@ -139,58 +185,2432 @@ TEST_CASE("Assign vs Equals", "[lex]") {
 
 //////////////////////////////////////////////////////////////////////
 
-TEST_CASE("PrintVisitor: binary expression", "[ast]") {
-  LiteralExpression lhs_num{lex::Token{lex::TokenType::kNumber, {.number = 1}}};
-  LiteralExpression rhs_num{lex::Token{lex::TokenType::kNumber, {.number = 2}}};
+static std::filesystem::path WriteTempSource(const std::string& name, const std::string& text) {
+  auto path = std::filesystem::temp_directory_path() / name;
+  std::ofstream{path} << text;
+  return path;
+}
 
-  BinaryExpression bin_expr{lex::Token{lex::TokenType::kDiv}, &lhs_num, &rhs_num};
+TEST_CASE("Mapped source", "[lex]") {
+  auto path = WriteTempSource("mapped_source.et", "var abc = \"str\"; # comment");
+  lex::Lexer l{path};
 
-  std::ostringstream oss;
-  PrintVisitor visitor{oss};
+  CHECK(l.Matches(lex::TokenType::kVar));
+  CHECK(l.Matches(lex::TokenType::kIdentifier));
+  CHECK(l.GetPreviousToken().value.identifier == "abc");
+  CHECK(l.Matches(lex::TokenType::kAssign));
+  CHECK(l.Matches(lex::TokenType::kString));
+  CHECK(l.GetPreviousToken().value.string == "str");
+  CHECK(l.Matches(lex::TokenType::kColon));
+  CHECK(l.Matches(lex::TokenType::kEOF));
 
-  visitor.VisitBinary(&bin_expr);
+  std::filesystem::remove(path);
+}
 
-  CHECK(oss.str() == "1 / 2");
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Mapped source: page-sized file", "[lex]") {
+  // No slack in the last page: the sentinel must come from elsewhere
+  std::string text(::sysconf(_SC_PAGESIZE), ' ');
+  text.back() = '1';
+
+  auto path = WriteTempSource("mapped_page.et", text);
+  lex::Lexer l{path};
+
+  CHECK(l.Matches(lex::TokenType::kNumber));
+  CHECK(l.GetPreviousToken().value.number == 1);
+  CHECK(l.Matches(lex::TokenType::kEOF));
+
+  std::filesystem::remove(path);
 }
 
 //////////////////////////////////////////////////////////////////////
 
-TEST_CASE("PrintVisitor: unary expression", "[ast]") {
-  LiteralExpression operand{lex::Token{lex::TokenType::kNumber, {.number = 22}}};
+TEST_CASE("Streaming: tokens straddle chunks", "[lex]") {
+  std::string text =
+      "# comment spanning chunks \n"
+      "fun long_function_name a1 a2 = {\n"
+      "  var s = \"a string literal, longer than a chunk\";\n"
+      "  long_function_name(12345, s) == !false;\n"
+      "};";
 
-  UnaryExpression un_expr{lex::Token{lex::TokenType::kNot}, &operand};
+  std::stringstream whole(text);
+  std::stringstream piped(text);
 
-  std::ostringstream oss;
-  PrintVisitor visitor{oss};
+  lex::Lexer expected{whole};
+  lex::Lexer streamed{piped, lex::StreamingMode{.chunk_size = 3}};
 
-  visitor.VisitUnary(&un_expr);
+  while (true) {
+    auto lhs = expected.GetNextToken();
+    auto rhs = streamed.GetNextToken();
 
-  CHECK(oss.str() == "!22");
+    REQUIRE(lhs.type == rhs.type);
+    CHECK(lhs.location.offset == rhs.location.offset);
+    CHECK(lhs.location.Resolve().lineno == rhs.location.Resolve().lineno);
+
+    if (lhs.type == lex::TokenType::kNumber) {
+      CHECK(lhs.value.number == rhs.value.number);
+    }
+    if (lhs.type == lex::TokenType::kIdentifier || lhs.type == lex::TokenType::kString) {
+      CHECK(lhs.value.string == rhs.value.string);
+    }
+
+    if (lhs.type == lex::TokenType::kEOF) {
+      break;
+    }
+  }
 }
 
 //////////////////////////////////////////////////////////////////////
 
-TEST_CASE("PrintVisitor: function declaration", "[ast]") {
-  VarAccessExpression lhs_a{lex::Token{lex::TokenType::kIdentifier, {.identifier = {"a"}}}};
-  VarAccessExpression rhs_b{lex::Token{lex::TokenType::kIdentifier, {.identifier = {"b"}}}};
+// Pipe-like source: no seeking, data arrives in small portions
+class PipeBuf : public std::streambuf {
+ public:
+  explicit PipeBuf(std::string data) : data_(std::move(data)) {
+  }
 
-  BinaryExpression bin_expr{lex::Token{lex::TokenType::kStar}, &lhs_a, &rhs_b};
-  ReturnExpression return_expr{lex::Token{lex::TokenType::kReturn}, &bin_expr};
-  ExprStatement expr_statement{&return_expr};
-  BlockExpression body{lex::Token{lex::TokenType::kLeftParen}, {&expr_statement}};
+ protected:
+  int_type underflow() override {
+    if (pos_ == data_.size()) {
+      return traits_type::eof();
+    }
+    size_t portion = std::min<size_t>(2, data_.size() - pos_);
+    char* begin = data_.data() + pos_;
+    setg(begin, begin, begin + portion);
+    pos_ += portion;
+    return traits_type::to_int_type(*begin);
+  }
 
-  FunDeclStatement fun_decl{lex::Token{lex::TokenType::kIdentifier, {.identifier = "main"}},
-                            {lex::Token{lex::TokenType::kIdentifier, {.identifier = "a"}},
-                             lex::Token{lex::TokenType::kIdentifier, {.identifier = "b"}}},
-                            &body};
+ private:
+  std::string data_;
+  size_t pos_{0};
+};
+
+TEST_CASE("Streaming: non-seekable source", "[lex]") {
+  PipeBuf buf{"var abc = \"x\";"};
+  std::istream source{&buf};
+  lex::Lexer l{source};
+
+  CHECK(l.Matches(lex::TokenType::kVar));
+  CHECK(l.Matches(lex::TokenType::kIdentifier));
+  CHECK(l.GetPreviousToken().value.identifier == "abc");
+  CHECK(l.Matches(lex::TokenType::kAssign));
+  CHECK(l.Matches(lex::TokenType::kString));
+  CHECK(l.GetPreviousToken().value.string == "x");
+  CHECK(l.Matches(lex::TokenType::kColon));
+  CHECK(l.Matches(lex::TokenType::kEOF));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Whitespace: line bookkeeping", "[lex]") {
+  std::stringstream source("a\n\n  b # comment\n\tc");
+  lex::Lexer l{source};
+
+  CHECK(l.Matches(lex::TokenType::kIdentifier));
+  CHECK(l.Matches(lex::TokenType::kIdentifier));
+  CHECK(l.GetPreviousToken().location.Resolve().lineno == 2);
+  CHECK(l.GetPreviousToken().location.Resolve().columnno == 2);
+  CHECK(l.Matches(lex::TokenType::kIdentifier));
+  CHECK(l.GetPreviousToken().location.Resolve().lineno == 3);
+  CHECK(l.GetPreviousToken().location.Resolve().columnno == 1);
+  CHECK(l.GetPreviousToken().location.Format() == "line = 4, column = 2");
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Locations: offsets and files", "[lex]") {
+  // 64-bit numbers make the payload union 8-byte aligned
+  static_assert(sizeof(lex::Token) == 24);
+
+  std::stringstream first_source("x\ny");
+  std::stringstream second_source("\n\nz");
+  lex::Lexer first{first_source};
+  lex::Lexer second{second_source};
+
+  auto x = first.GetNextToken().location;
+  auto y = first.GetNextToken().location;
+  auto z = second.GetNextToken().location;
+
+  CHECK(x.file_id == y.file_id);
+  CHECK(x.file_id != z.file_id);
+  CHECK(y.offset == 2);
+  CHECK(z.offset == 2);
+
+  CHECK(y.Format() == "line = 2, column = 1");
+  CHECK(z.Format() == "line = 3, column = 1");
+  CHECK(lex::Location{}.Format() == "line = 1, column = 1");
+}
+
+TEST_CASE("Locations: files are released", "[lex]") {
+  auto& map = lex::SourceMap::Session();
+  size_t files = map.FileCount();
+
+  // One registration per lexer, given back by its owner
+  for (int i = 0; i < 100; ++i) {
+    std::stringstream source("x\ny");
+    lex::Lexer l{source};
+    CHECK(l.GetNextToken().location.Format() == "line = 1, column = 1");
+    map.RemoveFile(l.GetFileId());
+  }
+  CHECK(map.FileCount() == files);
+
+  // Ids are not reused, stale locations can not land in another file
+  auto first = map.AddFile("first");
+  map.RemoveFile(first);
+  auto second = map.AddFile("second");
+  CHECK(second != first);
+  CHECK(map.FileName(second) == "second");
+  map.RemoveFile(second);
+
+  // A session drops everything registered in it
+  {
+    lex::SourceScope session;
+    CHECK(&lex::SourceMap::Session() == &session.Map());
+
+    for (int i = 0; i < 100; ++i) {
+      std::stringstream source("\n\nz");
+      lex::Lexer l{source};
+      CHECK(l.GetNextToken().location.Format() == "line = 3, column = 1");
+    }
+    CHECK(session.Map().FileCount() == 101);
+  }
+
+  CHECK(&lex::SourceMap::Session() == &map);
+  CHECK(map.FileCount() == files);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Scan kernels agree", "[lex]") {
+  using lex::kernels::Isa;
+
+  std::string long_name(70, 'x');
+  std::string text = "fun " + long_name + "_9 Az_09 = {" + std::string(50, ' ') + "\n\t\n" +
+                     "# " + std::string(100, '#') + "\n" + "  return " + long_name + ";" +
+                     std::string(33, '\n') + "};";
+
+  auto lex_all = [&] {
+    std::stringstream source(text);
+    lex::Lexer l{source};
+
+    std::vector<std::tuple<lex::TokenType, uint32_t, std::string>> tokens;
+    for (auto token = l.GetNextToken(); token.type != lex::TokenType::kEOF; token = l.GetNextToken()) {
+      std::string word;
+      if (token.type == lex::TokenType::kIdentifier) {
+        word = token.value.identifier;
+      }
+      tokens.emplace_back(token.type, token.location.offset, word);
+    }
+    return tokens;
+  };
+
+  auto initial = lex::kernels::ActiveIsa();
+
+  lex::kernels::ForceIsa(Isa::kScalar);
+  auto expected = lex_all();
+  CHECK(expected.size() == 10);
+
+  for (auto isa : {Isa::kSse2, Isa::kAvx2}) {
+    if (lex::kernels::IsSupported(isa)) {
+      lex::kernels::ForceIsa(isa);
+      CHECK(lex_all() == expected);
+    }
+  }
+
+  lex::kernels::ForceIsa(initial);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Interned identifiers", "[lex]") {
+  std::stringstream source("abc \"abc\" abd abc");
+  lex::Lexer l{source};
+
+  auto first = l.GetNextToken().value.identifier;
+  auto string = l.GetNextToken().value.string;
+  auto other = l.GetNextToken().value.identifier;
+  auto again = l.GetNextToken().value.identifier;
+
+  CHECK(first == again);
+  CHECK(first.id == again.id);
+  CHECK(first == string);  // Same text, same id
+  CHECK_FALSE(first == other);
+  CHECK(other.View() == "abd");
+
+  CHECK(lex::Symbol{}.View().empty());
+  CHECK(lex::Symbol{"abc"} == first);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Interner: concurrent interning", "[lex]") {
+  lex::Interner interner;
+
+  std::vector<std::vector<lex::SymbolId>> ids(4);
+  std::vector<std::thread> threads;
+
+  for (size_t t = 0; t < ids.size(); ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < 10'000; ++i) {
+        ids[t].push_back(interner.Intern(fmt::format("name_{}", i)));
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  CHECK(interner.Size() == 10'001);
+  for (size_t t = 1; t < ids.size(); ++t) {
+    CHECK(ids[t] == ids[0]);
+  }
+  CHECK(interner.View(ids[0][1234]) == "name_1234");
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Token buffer: lookahead and backtracking", "[lex]") {
+  std::stringstream source("var abc = f(1, \"s\");");
+  lex::Lexer l{source};
+
+  auto tokens = l.TokenizeAll();
+  CHECK(tokens.Size() == 11);
+  CHECK(tokens.Type(tokens.Size() - 1) == lex::TokenType::kEOF);
+
+  lex::TokenCursor cursor{tokens};
+  CHECK(cursor.PeekType(3) == lex::TokenType::kIdentifier);
+  CHECK(cursor.PeekType(100) == lex::TokenType::kEOF);
+
+  auto mark = cursor.Save();
+  CHECK(cursor.Matches(lex::TokenType::kVar));
+  CHECK(cursor.Matches(lex::TokenType::kIdentifier));
+  CHECK(cursor.GetPreviousToken().value.identifier == "abc");
+  CHECK_FALSE(cursor.Matches(lex::TokenType::kComma));
+
+  cursor.Restore(mark);
+  CHECK(cursor.Peek().type == lex::TokenType::kVar);
+
+  for (int i = 0; i < 5; ++i) {
+    cursor.Advance();
+  }
+  CHECK(cursor.Matches(lex::TokenType::kNumber));
+  CHECK(cursor.GetPreviousToken().value.number == 1);
+  CHECK(cursor.Matches(lex::TokenType::kComma));
+  CHECK(cursor.Matches(lex::TokenType::kString));
+  CHECK(cursor.GetPreviousToken().value.string == "s");
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("DFA: every operator spelling", "[lex]") {
+  for (auto type : lex::dfa::kOperators) {
+    std::stringstream source(std::string{lex::FormatTokenType(type)} + " x");
+    lex::Lexer l{source};
+
+    auto token = l.GetNextToken();
+    CHECK(token.type == type);
+    CHECK(token.location.offset == 0);
+    CHECK(l.GetNextToken().type == lex::TokenType::kIdentifier);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("DFA: longest match", "[lex]") {
+  std::stringstream source("!=== !!=<(");
+  lex::Lexer l{source};
+
+  auto tokens = l.TokenizeAll();
+  REQUIRE(tokens.Size() == 7);
+
+  CHECK(tokens.Type(0) == lex::TokenType::kNotEq);
+  CHECK(tokens.Type(1) == lex::TokenType::kEquals);
+  CHECK(tokens.GetLocation(1).offset == 2);
+  CHECK(tokens.Type(2) == lex::TokenType::kNot);
+  CHECK(tokens.Type(3) == lex::TokenType::kNotEq);
+  CHECK(tokens.Type(4) == lex::TokenType::kLess);
+  CHECK(tokens.Type(5) == lex::TokenType::kLeftParen);
+  CHECK(tokens.GetLocation(5).offset == 9);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Parallel: split points avoid literals and comments", "[lex]") {
+  std::string text = "a\n\"b\nc\nd\"\n# \"e\nf\n";
+
+  auto splits = lex::FindSplitPoints(text, 100);
+  CHECK(splits.front() == 0);
+  CHECK(splits.back() == text.size());
+
+  for (size_t split : splits) {
+    // Never inside the string literal "b\nc\nd"
+    CHECK((split <= 2 || split >= 10));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Parallel: same tokens as sequential", "[lex]") {
+  std::string text;
+  for (int i = 0; i < 200; ++i) {
+    text += fmt::format("var x{} = {} + f(\"multi\n# not a comment {}\n\");\n", i, i, i);
+    text += "# comment with a \" quote\n";
+    text += "if x != y then { return !x; } else { z == 1; }\n";
+  }
+  auto path = WriteTempSource("parallel_source.et", text);
+
+  lex::Lexer sequential{path};
+  auto expected = sequential.TokenizeAll();
+
+  util::ThreadPool pool{4};
+  auto actual = lex::TokenizeParallel(path, pool, lex::ParallelMode{.min_chunk_size = 64});
+
+  REQUIRE(actual.Size() == expected.Size());
+  for (size_t i = 0; i < expected.Size(); ++i) {
+    auto lhs = expected.At(i);
+    auto rhs = actual.At(i);
+
+    REQUIRE(lhs.type == rhs.type);
+    CHECK(lhs.location.offset == rhs.location.offset);
+    CHECK(lhs.location.Format() == rhs.location.Format());
+    CHECK(lhs.value.identifier.id == rhs.value.identifier.id);
+  }
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Parallel: a bad literal does not stop the other chunks", "[lex]") {
+  // Bad literal in the first chunk, plenty of work in the second
+  std::string text = "var a = 99999999999999999999999;\n";
+  for (int i = 0; i < 2000; ++i) {
+    text += fmt::format("var x{} = f({}, \"s\") == y;\n", i, i);
+  }
+  auto path = WriteTempSource("parallel_bad_literal.et", text);
+
+  lex::Lexer sequential{path};
+  auto expected = sequential.TokenizeAll();
+
+  util::ThreadPool pool{2};
+  auto actual = lex::TokenizeParallel(path, pool, lex::ParallelMode{.min_chunk_size = 64});
+
+  REQUIRE(actual.Size() == expected.Size());
+  for (size_t i = 0; i < expected.Size(); ++i) {
+    REQUIRE(actual.Type(i) == expected.Type(i));
+  }
+
+  REQUIRE(actual.Type(3) == lex::TokenType::kError);
+  CHECK(actual.At(3).value.error == lex::errors::LexErrorCode::kNumberOverflow);
+
+  std::filesystem::remove(path);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Numbers: decimal, hex and binary", "[lex]") {
+  std::stringstream source("0 7 12345678 123456789012 9223372036854775807 0x7fFF 0XA 0b101 0B0 00012");
+  lex::Lexer l{source};
+
+  for (int64_t expected : {0ll, 7ll, 12345678ll, 123456789012ll, 9223372036854775807ll, 0x7fffll, 10ll, 5ll, 0ll, 12ll}) {
+    CHECK(l.Matches(lex::TokenType::kNumber));
+    CHECK(l.GetPreviousToken().value.number == expected);
+  }
+  CHECK(l.Matches(lex::TokenType::kEOF));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Numbers: digits straddle chunks", "[lex]") {
+  std::stringstream source("1234567890123 0x123456789abc");
+  lex::Lexer l{source, lex::StreamingMode{.chunk_size = 3}};
+
+  CHECK(l.Matches(lex::TokenType::kNumber));
+  CHECK(l.GetPreviousToken().value.number == 1234567890123);
+  CHECK(l.Matches(lex::TokenType::kNumber));
+  CHECK(l.GetPreviousToken().value.number == 0x123456789abc);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Numbers: overflow is diagnosed", "[lex]") {
+  using lex::errors::LexErrorCode;
+
+  std::pair<const char*, LexErrorCode> cases[] = {
+      {"9223372036854775808", LexErrorCode::kNumberOverflow},
+      {"99999999999999999999999", LexErrorCode::kNumberOverflow},
+      {"0x8000000000000000", LexErrorCode::kNumberOverflow},
+      {"0x", LexErrorCode::kMissingDigits},
+      {"0b2", LexErrorCode::kMissingDigits},
+  };
+
+  for (auto [text, code] : cases) {
+    std::stringstream source(text);
+    lex::Lexer l{source};
+
+    auto token = l.GetNextToken();
+    REQUIRE(token.type == lex::TokenType::kError);
+    CHECK(token.value.error == code);
+  }
+
+  std::stringstream source("x = 0x0000000000000000001;");
+  lex::Lexer l{source};
+  CHECK(l.TokenizeAll().Type(2) == lex::TokenType::kNumber);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Parser: lex errors are reported with the parse errors", "[parse]") {
+  std::stringstream source("var a = 99999999999999999999999; var b = 0x; var c = 1; var = 2;");
+  lex::Lexer l{source};
+  Parser p{l};
+
+  auto declarations = p.ParseFile();
+  REQUIRE(declarations.size() == 1);
+  CHECK(static_cast<VarDeclStatement*>(declarations[0])->name.value.identifier.View() == "c");
+
+  using parse::errors::ErrorCode;
+
+  auto errors = p.GetErrors().All();
+  REQUIRE(errors.size() == 3);
+  CHECK(errors[0].code == ErrorCode::kLexError);
+  CHECK(errors[1].code == ErrorCode::kLexError);
+  CHECK(errors[2].code == ErrorCode::kExpectedToken);
+
+  auto text = p.FormatErrors();
+  CHECK(text.find("out of the 64-bit range") != std::string::npos);
+  CHECK(text.find("Expected digits") != std::string::npos);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+static void CheckSameTokens(const lex::TokenBuffer& actual, const std::string& text) {
+  std::stringstream source(text);
+  lex::Lexer l{source};
+  auto expected = l.TokenizeAll();
+
+  REQUIRE(actual.Size() == expected.Size());
+  for (size_t i = 0; i < expected.Size(); ++i) {
+    auto lhs = expected.At(i);
+    auto rhs = actual.At(i);
+
+    REQUIRE(lhs.type == rhs.type);
+    REQUIRE(lhs.location.offset == rhs.location.offset);
+    REQUIRE(lhs.location.Format() == rhs.location.Format());
+    REQUIRE(lhs.value.number == rhs.value.number);
+  }
+}
+
+TEST_CASE("Incremental: one-character edits", "[lex]") {
+  std::string text = "var abc = 1;\nfun f(x) = x == 2;  # note\nvar d = !abc;\n";
+
+  std::stringstream source(text);
+  lex::Lexer l{source};
+  auto tokens = l.TokenizeAll();
+
+  // Grow an identifier, merge two operators, then break a comment
+  auto apply = [&](lex::TextEdit edit) {
+    text.replace(edit.offset, edit.removed, edit.inserted);
+    return lex::Relex(tokens, text, edit);
+  };
+
+  auto range = apply({.offset = 7, .removed = 0, .inserted = "c"});
+  CheckSameTokens(tokens, text);
+  CHECK(range.end - range.begin <= 3);
+
+  apply({.offset = 28, .removed = 1, .inserted = "="});
+  CheckSameTokens(tokens, text);
+
+  apply({.offset = text.find('#') + 2, .removed = 0, .inserted = "\n return"});
+  CheckSameTokens(tokens, text);
+
+  apply({.offset = text.size(), .removed = 0, .inserted = "x"});
+  CheckSameTokens(tokens, text);
+
+  apply({.offset = 0, .removed = text.size(), .inserted = ""});
+  CheckSameTokens(tokens, text);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Incremental: edits before the first token and in comments", "[lex]") {
+  struct Case {
+    std::string text;
+    lex::TextEdit edit;
+  };
+
+  Case cases[] = {
+      // Leading whitespace
+      {"  x", {.offset = 0, .removed = 0, .inserted = "y"}},
+      {"  x", {.offset = 1, .removed = 1, .inserted = "y "}},
+
+      // Header comment
+      {"# header\nfun f = 1;", {.offset = 0, .removed = 0, .inserted = "var"}},
+      {"# header\nfun f = 1;", {.offset = 3, .removed = 0, .inserted = "\nvar"}},
+      {"#c\nx y", {.offset = 2, .removed = 1, .inserted = ""}},
+
+      // Comment between tokens
+      {"x # c\ny z", {.offset = 4, .removed = 0, .inserted = "\nw"}},
+      {"x # c\ny z", {.offset = 5, .removed = 1, .inserted = ""}},
+      {"x # c\ny z", {.offset = 2, .removed = 1, .inserted = ""}},
+  };
+
+  for (auto& [text, edit] : cases) {
+    std::stringstream source(text);
+    lex::Lexer l{source};
+    auto tokens = l.TokenizeAll();
+
+    text.replace(edit.offset, edit.removed, edit.inserted);
+    lex::Relex(tokens, text, edit);
+    CheckSameTokens(tokens, text);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Incremental: random edits", "[lex]") {
+  // No zeros: random edits must not produce "0x" without digits
+  std::string text;
+  for (int i = 0; i < 50; ++i) {
+    text += fmt::format("var x{} = f({}, y) == {}; # c\n", "abc"[i % 3], 7 * (i % 3 + 1), i % 9 + 1);
+  }
+
+  std::stringstream source(text);
+  lex::Lexer l{source};
+  auto tokens = l.TokenizeAll();
+
+  const char* pieces[] = {"a", "b", "7", " ", "\n", "=", "==", "(", "# c\n", "if", "!", ";"};
+
+  uint64_t seed = 42;
+  auto next = [&seed](size_t bound) {
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    return (seed >> 33) % bound;
+  };
+
+  for (int i = 0; i < 300; ++i) {
+    size_t offset = next(text.size() + 1);
+    size_t removed = next(std::min<size_t>(text.size() - offset, 4) + 1);
+    std::string_view inserted = pieces[next(std::size(pieces))];
+
+    text.replace(offset, removed, inserted);
+    lex::Relex(tokens, text, {offset, removed, inserted});
+
+    if (i % 25 == 0) {
+      CheckSameTokens(tokens, text);
+    }
+  }
+
+  CheckSameTokens(tokens, text);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Arena: nodes are bump allocated", "[ast]") {
+  Arena arena;
+
+  auto* lhs = arena.Make<LiteralExpression>(lex::Token{lex::TokenType::kNumber, {.number = 1}});
+  auto* rhs = arena.Make<LiteralExpression>(lex::Token{lex::TokenType::kNumber, {.number = 2}});
+  auto* sum = arena.Make<BinaryExpression>(lex::Token{lex::TokenType::kPlus}, lhs, rhs);
+
+  // Consecutive nodes are laid out one after another
+  CHECK(reinterpret_cast<char*>(rhs) - reinterpret_cast<char*>(lhs) == sizeof(LiteralExpression));
+  CHECK(reinterpret_cast<uintptr_t>(sum) % alignof(BinaryExpression) == 0);
 
   std::ostringstream oss;
   PrintVisitor visitor{oss};
+  sum->Accept(&visitor);
+  CHECK(oss.str() == "1 + 2");
 
-  visitor.VisitFunDecl(&fun_decl);
+  CHECK(arena.BytesAllocated() >= 2 * sizeof(LiteralExpression) + sizeof(BinaryExpression));
+}
 
-  CHECK(oss.str() ==
-        "fun main a b  = {\n"
-        "return a * b;\n"
-        "}\n");
-}
\ No newline at end of file
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Arena: destructors and large objects", "[ast]") {
+  struct Counted {
+    int* counter;
+    ~Counted() {
+      ++*counter;
+    }
+  };
+
+  int destroyed = 0;
+
+  {
+    Arena arena{128};
+
+    for (int i = 0; i < 100; ++i) {
+      arena.Make<Counted>(&destroyed);
+    }
+
+    // Does not fit into a block, gets its own
+    auto* big = static_cast<char*>(arena.Allocate(1000, 1));
+    std::fill_n(big, 1000, 'x');
+
+    auto* call = arena.Make<FnCallExpression>(lex::Token{lex::TokenType::kIdentifier},
+                                              std::vector<Expression*>(50, nullptr));
+    CHECK(call->args.size() == 50);
+    CHECK(destroyed == 0);
+  }
+
+  CHECK(destroyed == 100);
+
+  // Nodes are registered for destruction unless they opt out
+  STATIC_REQUIRE(kArenaDestroys<FnCallExpression>);
+  STATIC_REQUIRE(kArenaDestroys<BlockExpression>);
+  STATIC_REQUIRE(kArenaDestroys<FunDeclStatement>);
+  STATIC_REQUIRE_FALSE(kArenaDestroys<LiteralExpression>);
+  STATIC_REQUIRE_FALSE(kArenaDestroys<VarAccessExpression>);
+  STATIC_REQUIRE_FALSE(kArenaDestroys<BinaryExpression>);
+  STATIC_REQUIRE_FALSE(kArenaDestroys<ComparisonExpression>);
+  STATIC_REQUIRE_FALSE(kArenaDestroys<UnaryExpression>);
+  STATIC_REQUIRE_FALSE(kArenaDestroys<IfExpression>);
+  STATIC_REQUIRE_FALSE(kArenaDestroys<ReturnExpression>);
+  STATIC_REQUIRE_FALSE(kArenaDestroys<ExprStatement>);
+  STATIC_REQUIRE_FALSE(kArenaDestroys<AssignmentStatement>);
+  STATIC_REQUIRE_FALSE(kArenaDestroys<VarDeclStatement>);
+  STATIC_REQUIRE(kArenaDestroys<Counted>);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Node kinds: isa, cast and dyn_cast", "[ast]") {
+  LiteralExpression number{lex::Token{lex::TokenType::kNumber, {.number = 1}}};
+  VarAccessExpression variable{lex::Token{lex::TokenType::kIdentifier}};
+  VarDeclStatement declaration{lex::Token{lex::TokenType::kIdentifier}, &number};
+  ExprStatement statement{&variable};
+
+  CHECK(number.GetKind() == NodeKind::kLiteral);
+  CHECK(isa<Expression>(&number));
+  CHECK_FALSE(isa<LvalueExpression>(&number));
+  CHECK_FALSE(isa<Statement>(&number));
+
+  CHECK(isa<LvalueExpression>(&variable));
+  CHECK(isa<Expression>(&variable));
+
+  CHECK(isa<Declaration>(&declaration));
+  CHECK(isa<Statement>(&declaration));
+  CHECK_FALSE(isa<FunDeclStatement>(&declaration));
+  CHECK_FALSE(isa<Declaration>(&statement));
+  CHECK(isa<Statement>(&statement));
+
+  TreeNode* node = &variable;
+  CHECK(cast<VarAccessExpression>(node) == &variable);
+  CHECK(dyn_cast<LvalueExpression>(node) == &variable);
+  CHECK(dyn_cast<LiteralExpression>(node) == nullptr);
+  CHECK(dyn_cast<Expression>(static_cast<TreeNode*>(nullptr)) == nullptr);
+
+  CHECK(node->as<Expression>() == &variable);
+  CHECK(static_cast<TreeNode*>(&declaration)->as<Expression>() == nullptr);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Flat tree: round trip through PrintVisitor", "[ast]") {
+  Arena arena;
+
+  auto number = [&](int64_t value) {
+    return arena.Make<LiteralExpression>(lex::Token{lex::TokenType::kNumber, {.number = value}});
+  };
+
+  auto* x = arena.Make<VarAccessExpression>(lex::Token{lex::TokenType::kIdentifier, {.identifier = "x"}});
+  auto* cmp = arena.Make<ComparisonExpression>(lex::Token{lex::TokenType::kLess}, x, number(3));
+  auto* call = arena.Make<FnCallExpression>(lex::Token{lex::TokenType::kIdentifier, {.identifier = "f"}},
+                                            std::vector<Expression*>{number(1), number(2)});
+  auto* sum = arena.Make<BinaryExpression>(lex::Token{lex::TokenType::kPlus}, call, number(4));
+  auto* ret = arena.Make<ReturnExpression>(lex::Token{lex::TokenType::kReturn}, sum);
+  auto* body = arena.Make<BlockExpression>(lex::Token{lex::TokenType::kLeftCBrace},
+                                           std::vector<Statement*>{arena.Make<ExprStatement>(ret)});
+  auto* fun = arena.Make<FunDeclStatement>(lex::Token{lex::TokenType::kIdentifier, {.identifier = "g"}},
+                                           std::vector<lex::Token>{x->variable}, body);
+
+  FlatTree tree;
+  auto cmp_id = tree.Flatten(cmp);
+  auto fun_id = tree.Flatten(fun);
+
+  CHECK(tree.Kind(cmp_id) == NodeKind::kComparison);
+  REQUIRE(tree.Children(cmp_id).size() == 2);
+  CHECK(tree.Kind(tree.Children(cmp_id)[0]) == NodeKind::kVarAccess);
+  CHECK(tree.GetToken(tree.Children(cmp_id)[1]).value.number == 3);
+
+  CHECK(tree.Kind(fun_id) == NodeKind::kFunDecl);
+  CHECK(tree.Children(fun_id).size() == 2);
+  CHECK(tree.GetToken(fun_id).value.identifier == "g");
+
+  for (auto [pointer, flat] : {std::pair<TreeNode*, FlatTree::NodeId>{cmp, cmp_id}, {fun, fun_id}}) {
+    std::ostringstream expected;
+    PrintVisitor pointer_visitor{expected};
+    pointer->Accept(&pointer_visitor);
+
+    Arena copy;
+    std::ostringstream actual;
+    PrintVisitor flat_visitor{actual};
+    tree.Materialize(flat, copy)->Accept(&flat_visitor);
+
+    CHECK(actual.str() == expected.str());
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+// Fully parenthesized expression, computed on the ids
+class FlatRenderer : public FlatWalker<FlatRenderer> {
+ public:
+  void Leave(const FlatTree& tree, FlatTree::NodeId id) {
+    auto token = tree.GetToken(id);
+    size_t arity = tree.Children(id).size();
+
+    std::vector<std::string> operands(parts.end() - arity, parts.end());
+    parts.resize(parts.size() - arity);
+
+    switch (tree.Kind(id)) {
+      case NodeKind::kLiteral:
+        parts.push_back(fmt::format("{}", token.value.number));
+        break;
+      case NodeKind::kVarAccess:
+        parts.emplace_back(lex::Interner::Session().View(token.value.identifier.id));
+        break;
+      case NodeKind::kUnary:
+        parts.push_back(fmt::format("({}{})", lex::FormatTokenType(token.type), operands[0]));
+        break;
+      case NodeKind::kFnCall:
+        parts.push_back(fmt::format("{}({})", lex::Interner::Session().View(token.value.identifier.id),
+                                    fmt::join(operands, ", ")));
+        break;
+      default:
+        parts.push_back(fmt::format("({} {} {})", operands[0], lex::FormatTokenType(token.type), operands[1]));
+        break;
+    }
+  }
+
+  std::vector<std::string> parts;
+};
+
+TEST_CASE("Flat tree: built directly", "[ast]") {
+  FlatTree tree;
+
+  auto one = tree.Add(NodeKind::kLiteral, lex::Token{lex::TokenType::kNumber, {.number = 1}});
+  auto two = tree.Add(NodeKind::kLiteral, lex::Token{lex::TokenType::kNumber, {.number = 2}});
+  FlatTree::NodeId operands[] = {one, two};
+  auto div = tree.Add(NodeKind::kBinary, lex::Token{lex::TokenType::kDiv}, operands);
+
+  CHECK(tree.Size() == 3);
+  CHECK(tree.Children(one).empty());
+
+  FlatRenderer renderer;
+  renderer.Walk(tree, div);
+  CHECK(renderer.parts == std::vector<std::string>{"(1 / 2)"});
+}
+
+TEST_CASE("Flat tree: passes run on ids", "[ast]") {
+  std::stringstream source("f(x, -1) * (y + 2) == 3");
+  lex::Lexer l{source};
+  Parser p{l};
+  auto* expr = p.ParseExpression();
+  REQUIRE(expr != nullptr);
+
+  FlatTree tree;
+  auto root = tree.Flatten(expr);
+
+  FlatRenderer renderer;
+  renderer.Walk(tree, root);
+  CHECK(renderer.parts == std::vector<std::string>{"((f(x, (-1)) * (y + 2)) == 3)"});
+}
+
+TEST_CASE("Flat tree: if without else", "[ast]") {
+  std::stringstream source("var x = if a then b; fun g = if a then { if b then c } else d;");
+  lex::Lexer l{source};
+  Parser p{l};
+  auto declarations = p.ParseFile();
+  REQUIRE(p.GetErrors().Empty());
+
+  FlatTree tree;
+  for (auto* declaration : declarations) {
+    auto id = tree.Flatten(declaration);
+
+    Arena arena;
+    CHECK(DumpToString(tree.Materialize(id, arena), DumpFormat::kSExpression) ==
+          DumpToString(declaration, DumpFormat::kSExpression));
+  }
+
+  auto var = tree.Flatten(declarations[0]);
+  auto if_id = tree.Children(var)[0];
+  CHECK(tree.Kind(if_id) == NodeKind::kIf);
+  CHECK(tree.Children(if_id).size() == 2);
+}
+
+TEST_CASE("Flat tree: deep trees", "[ast]") {
+  Arena arena;
+
+  Expression* expr = arena.Make<LiteralExpression>(lex::Token{lex::TokenType::kNumber, {.number = 1}});
+  for (int i = 0; i < 200'000; ++i) {
+    expr = arena.Make<UnaryExpression>(lex::Token{lex::TokenType::kMinus}, expr);
+  }
+
+  FlatTree tree;
+  auto root = tree.Flatten(expr);
+  CHECK(tree.Size() == 200'001);
+
+  auto* copy = tree.Materialize(root, arena);
+  CHECK(DumpToString(copy, DumpFormat::kSExpression) == DumpToString(expr, DumpFormat::kSExpression));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+// Fully parenthesized rendering of an expression
+static std::string Render(Expression* expr) {
+  if (auto* binary = dyn_cast<BinaryExpression>(expr)) {
+    return fmt::format("({} {} {})", Render(binary->lhs), lex::FormatTokenType(binary->binary_operator.type),
+                       Render(binary->rhs));
+  }
+
+  if (auto* cmp = dyn_cast<ComparisonExpression>(expr)) {
+    return fmt::format("({} {} {})", Render(cmp->lhs), lex::FormatTokenType(cmp->cmp_operator.type),
+                       Render(cmp->rhs));
+  }
+
+  if (auto* unary = dyn_cast<UnaryExpression>(expr)) {
+    return fmt::format("({}{})", lex::FormatTokenType(unary->unary_operator.type), Render(unary->operand));
+  }
+
+  if (auto* call = dyn_cast<FnCallExpression>(expr)) {
+    std::vector<std::string> args;
+    for (auto* arg : call->args) {
+      args.push_back(Render(arg));
+    }
+    return fmt::format("{}({})", call->name.value.identifier, fmt::join(args, ", "));
+  }
+
+  if (auto* literal = dyn_cast<LiteralExpression>(expr)) {
+    return std::to_string(literal->literal.value.number);
+  }
+
+  if (auto* ret = dyn_cast<ReturnExpression>(expr)) {
+    return fmt::format("return {}", Render(ret->expression));
+  }
+
+  return std::string{cast<VarAccessExpression>(expr)->variable.value.identifier.View()};
+}
+
+static std::string ParseAndRender(const std::string& text) {
+  std::stringstream source(text);
+  lex::Lexer l{source};
+  Parser p{l};
+  return Render(p.ParseExpression());
+}
+
+TEST_CASE("Parser: precedence and associativity", "[parse]") {
+  CHECK(ParseAndRender("1 + 2 * 3") == "(1 + (2 * 3))");
+  CHECK(ParseAndRender("1 - 2 - 3") == "((1 - 2) - 3)");
+  CHECK(ParseAndRender("8 / 4 / 2") == "((8 / 4) / 2)");
+  CHECK(ParseAndRender("(1 + 2) * 3") == "((1 + 2) * 3)");
+  CHECK(ParseAndRender("-a * !b") == "((-a) * (!b))");
+  CHECK(ParseAndRender("- - a") == "(-(-a))");
+  CHECK(ParseAndRender("a < b == c > d") == "((a < b) == (c > d))");
+  CHECK(ParseAndRender("a == b != c") == "((a == b) != c)");
+  CHECK(ParseAndRender("-f(1, g(), (2 + x) * 3) + 1") == "((-f(1, g(), ((2 + x) * 3))) + 1)");
+  CHECK(ParseAndRender("return a + b") == "return (a + b)");
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Parser: levels stop at looser operators", "[parse]") {
+  std::stringstream source("a + b * c == d;");
+  lex::Lexer l{source};
+  Parser p{l};
+
+  CHECK(Render(p.ParseBinary()) == "(a + (b * c))");
+
+  // `==` is left for the caller
+  CHECK(p.ParseExpression() == nullptr);
+  REQUIRE(p.GetErrors().Size() == 1);
+  CHECK(p.GetErrors().All()[0].code == parse::errors::ErrorCode::kExpectedPrimary);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Parser: malformed expressions", "[parse]") {
+  for (auto text : {"(1 + 2", "f(1, 2", "1 +", "f(1,)", "(1, 2)", ")"}) {
+    std::stringstream source(text);
+    lex::Lexer l{source};
+    Parser p{l};
+    CHECK(p.ParseExpression() == nullptr);
+    CHECK_FALSE(p.GetErrors().Empty());
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Parser: declarations and statements", "[parse]") {
+  std::stringstream source(
+      "var x = 1 + 2;"
+      "fun id a = a;"
+      "fun main argc argv = { var y = x; y = y * 2; print(y); y };");
+  lex::Lexer l{source};
+  Parser p{l};
+
+  auto declarations = p.ParseFile();
+  CHECK(p.GetErrors().Empty());
+  REQUIRE(declarations.size() == 3);
+
+  CHECK(isa<VarDeclStatement>(declarations[0]));
+
+  auto* id = dyn_cast<FunDeclStatement>(declarations[1]);
+  REQUIRE(id);
+  CHECK(id->params.size() == 1);
+  CHECK(id->body->statements.size() == 1);  // `a` wrapped into a block
+
+  auto* main = dyn_cast<FunDeclStatement>(declarations[2]);
+  REQUIRE(main);
+  CHECK(main->params.size() == 2);
+  REQUIRE(main->body->statements.size() == 4);
+  CHECK(isa<VarDeclStatement>(main->body->statements[0]));
+  CHECK(isa<AssignmentStatement>(main->body->statements[1]));
+  CHECK(isa<ExprStatement>(main->body->statements[2]));
+  CHECK(isa<ExprStatement>(main->body->statements[3]));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Parser: every error of a file in one pass", "[parse]") {
+  using parse::errors::ErrorCode;
+
+  std::stringstream source(
+      "var a = ;\n"                      // no expression
+      "var b = 1\n"                      // no `;`, resumes at `var`
+      "var c = 2;\n"                     // fine
+      "fun f = { 1 + ; g(2); 3 = 4; };\n"  // two errors inside the block
+      "5 6;\n"                           // not a declaration
+      "var d = 3;\n");
+  lex::Lexer l{source};
+  Parser p{l};
+
+  auto declarations = p.ParseFile();
+
+  std::vector<ErrorCode> codes;
+  for (auto& error : p.GetErrors().All()) {
+    codes.push_back(error.code);
+  }
+
+  CHECK(codes == std::vector{ErrorCode::kExpectedPrimary, ErrorCode::kExpectedToken,  //
+                             ErrorCode::kExpectedPrimary, ErrorCode::kExpectedLvalue,
+                             ErrorCode::kExpectedDeclaration});
+
+  // c, f (recovered inside its body) and d survive
+  REQUIRE(declarations.size() == 3);
+  auto* f = dyn_cast<FunDeclStatement>(declarations[1]);
+  REQUIRE(f);
+  CHECK(f->body->statements.size() == 1);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Parser: errors are formatted on demand", "[parse]") {
+  std::stringstream source("var = 1; var x = 1 2;");
+  lex::Lexer l{source};
+  Parser p{l};
+
+  CHECK(p.ParseFile().empty());
+  REQUIRE(p.GetErrors().Size() == 2);
+
+  auto text = p.FormatErrors();
+  CHECK(text.find("Expected token identifier") != std::string::npos);
+  CHECK(text.find("Expected token ;") != std::string::npos);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+static std::string PrintDeclarations(const std::vector<Declaration*>& declarations) {
+  std::ostringstream oss;
+  PrintVisitor visitor{oss};
+  for (auto* declaration : declarations) {
+    declaration->Accept(&visitor);
+  }
+  return oss.str();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Parallel parse: declaration boundaries", "[parse]") {
+  std::stringstream source("var a = 1; fun f x = { var b = x; (b) }; fun g = f(1);");
+  lex::Lexer l{source};
+  auto tokens = l.TokenizeAll();
+
+  auto boundaries = parse::FindDeclarationBoundaries(tokens);
+  REQUIRE(boundaries.size() == 4);
+  CHECK(boundaries[0] == 0);
+  CHECK(tokens.Type(boundaries[1]) == lex::TokenType::kFun);
+  CHECK(tokens.Type(boundaries[2]) == lex::TokenType::kFun);
+  CHECK(boundaries[3] == tokens.Size() - 1);  // The inner `var` is not a boundary
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Parallel parse: same tree as sequential", "[parse]") {
+  std::string text;
+  for (int i = 0; i < 300; ++i) {
+    text += fmt::format("var x{} = {} * (y + {});\n", i, i, i + 1);
+    text += fmt::format("fun f{} a b = {{ var c = a - b; c = c + f(x{}, {{ 1 }}); return c }};\n", i, i);
+  }
+
+  std::stringstream source(text);
+  lex::Lexer l{source};
+  auto tokens = l.TokenizeAll();
+
+  Parser sequential{tokens};
+  auto expected = PrintDeclarations(sequential.ParseFile());
+  REQUIRE(sequential.GetErrors().Empty());
+
+  util::ThreadPool pool{4};
+  auto file = parse::ParseParallel(tokens, pool, parse::ParallelMode{.min_task_tokens = 64});
+
+  CHECK(file.arenas.size() > 1);
+  CHECK(file.declarations.size() == 600);
+  CHECK(file.errors.Empty());
+  CHECK(PrintDeclarations(file.declarations) == expected);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Parallel parse: errors refer to the whole buffer", "[parse]") {
+  std::string text;
+  for (int i = 0; i < 50; ++i) {
+    text += (i % 10 == 7) ? "var broken = ;\n" : fmt::format("var x{} = {};\n", i, i);
+  }
+
+  std::stringstream source(text);
+  lex::Lexer l{source};
+  auto tokens = l.TokenizeAll();
+
+  Parser sequential{tokens};
+  sequential.ParseFile();
+
+  util::ThreadPool pool{4};
+  auto file = parse::ParseParallel(tokens, pool, parse::ParallelMode{.min_task_tokens = 16});
+
+  CHECK(file.declarations.size() == 45);
+  CHECK(file.errors.Format(tokens) == sequential.FormatErrors());
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Parser: deep nesting does not use the C++ stack", "[parse]") {
+  constexpr size_t kDepth = 200'000;
+
+  SECTION("parentheses") {
+    std::stringstream source(std::string(kDepth, '(') + "1" + std::string(kDepth, ')'));
+    lex::Lexer l{source};
+    Parser p{l};
+    CHECK(isa<LiteralExpression>(p.ParseExpression()));
+  }
+
+  SECTION("prefix operators") {
+    std::stringstream source(std::string(kDepth, '-') + "1");
+    lex::Lexer l{source};
+    Parser p{l};
+
+    size_t depth = 0;
+    for (auto* expr = p.ParseExpression(); auto* unary = dyn_cast<UnaryExpression>(expr); expr = unary->operand) {
+      ++depth;
+    }
+    CHECK(depth == kDepth);
+  }
+
+  SECTION("chained operators and calls") {
+    std::string text;
+    for (size_t i = 0; i < kDepth; ++i) {
+      text += "f(1 + ";
+    }
+    text += "1" + std::string(kDepth, ')');
+
+    std::stringstream source(text);
+    lex::Lexer l{source};
+    Parser p{l};
+    CHECK(isa<FnCallExpression>(p.ParseExpression()));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("PrintVisitor: binary expression", "[ast]") {
+  LiteralExpression lhs_num{lex::Token{lex::TokenType::kNumber, {.number = 1}}};
+  LiteralExpression rhs_num{lex::Token{lex::TokenType::kNumber, {.number = 2}}};
+
+  BinaryExpression bin_expr{lex::Token{lex::TokenType::kDiv}, &lhs_num, &rhs_num};
+
+  std::ostringstream oss;
+  PrintVisitor visitor{oss};
+
+  visitor.VisitBinary(&bin_expr);
+
+  CHECK(oss.str() == "1 / 2");
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("PrintVisitor: unary expression", "[ast]") {
+  LiteralExpression operand{lex::Token{lex::TokenType::kNumber, {.number = 22}}};
+
+  UnaryExpression un_expr{lex::Token{lex::TokenType::kNot}, &operand};
+
+  std::ostringstream oss;
+  PrintVisitor visitor{oss};
+
+  visitor.VisitUnary(&un_expr);
+
+  CHECK(oss.str() == "!22");
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("PrintVisitor: function declaration", "[ast]") {
+  VarAccessExpression lhs_a{lex::Token{lex::TokenType::kIdentifier, {.identifier = {"a"}}}};
+  VarAccessExpression rhs_b{lex::Token{lex::TokenType::kIdentifier, {.identifier = {"b"}}}};
+
+  BinaryExpression bin_expr{lex::Token{lex::TokenType::kStar}, &lhs_a, &rhs_b};
+  ReturnExpression return_expr{lex::Token{lex::TokenType::kReturn}, &bin_expr};
+  ExprStatement expr_statement{&return_expr};
+  BlockExpression body{lex::Token{lex::TokenType::kLeftParen}, {&expr_statement}};
+
+  FunDeclStatement fun_decl{lex::Token{lex::TokenType::kIdentifier, {.identifier = "main"}},
+                            {lex::Token{lex::TokenType::kIdentifier, {.identifier = "a"}},
+                             lex::Token{lex::TokenType::kIdentifier, {.identifier = "b"}}},
+                            &body};
+
+  std::ostringstream oss;
+  PrintVisitor visitor{oss};
+
+  visitor.VisitFunDecl(&fun_decl);
+
+  CHECK(oss.str() ==
+        "fun main a b  = {\n"
+        "return a * b;\n"
+        "}\n");
+}
+//////////////////////////////////////////////////////////////////////
+
+// Constant folding of integer expressions, variables and calls are 0
+class Evaluator : public StaticVisitor<Evaluator, int64_t> {
+ public:
+  int64_t VisitExprStatement(ExprStatement* node) {
+    return Visit(node->expr);
+  }
+
+  int64_t VisitAssignment(AssignmentStatement*) {
+    return 0;
+  }
+
+  int64_t VisitVarDecl(VarDeclStatement*) {
+    return 0;
+  }
+
+  int64_t VisitFunDecl(FunDeclStatement* node) {
+    return Visit(node->body);
+  }
+
+  int64_t VisitComparison(ComparisonExpression* node) {
+    int64_t lhs = Visit(node->lhs);
+    int64_t rhs = Visit(node->rhs);
+
+    switch (node->cmp_operator.type) {
+      case lex::TokenType::kEquals:
+        return lhs == rhs;
+      case lex::TokenType::kNotEq:
+        return lhs != rhs;
+      case lex::TokenType::kLess:
+        return lhs < rhs;
+      default:
+        return lhs > rhs;
+    }
+  }
+
+  int64_t VisitBinary(BinaryExpression* node) {
+    int64_t lhs = Visit(node->lhs);
+    int64_t rhs = Visit(node->rhs);
+
+    switch (node->binary_operator.type) {
+      case lex::TokenType::kPlus:
+        return lhs + rhs;
+      case lex::TokenType::kMinus:
+        return lhs - rhs;
+      case lex::TokenType::kStar:
+        return lhs * rhs;
+      default:
+        return lhs / rhs;
+    }
+  }
+
+  int64_t VisitUnary(UnaryExpression* node) {
+    int64_t operand = Visit(node->operand);
+    return node->unary_operator.type == lex::TokenType::kMinus ? -operand : !operand;
+  }
+
+  int64_t VisitFnCall(FnCallExpression*) {
+    return 0;
+  }
+
+  int64_t VisitBlock(BlockExpression* node) {
+    int64_t last = 0;
+    for (auto* statement : node->statements) {
+      last = Visit(statement);
+    }
+    return last;
+  }
+
+  int64_t VisitIf(IfExpression* node) {
+    return Visit(node->condition_expr) ? Visit(node->true_expr) : Visit(node->false_expr);
+  }
+
+  int64_t VisitLiteral(LiteralExpression* node) {
+    return node->literal.value.number;
+  }
+
+  int64_t VisitVarAccess(VarAccessExpression*) {
+    return 0;
+  }
+
+  int64_t VisitReturn(ReturnExpression* node) {
+    return Visit(node->expression);
+  }
+};
+
+TEST_CASE("StaticVisitor: results are returned, not stored", "[ast]") {
+  auto evaluate = [](std::string text) {
+    std::stringstream source(text);
+    lex::Lexer l{source};
+    Parser p{l};
+    return Evaluator{}.Visit(p.ParseExpression());
+  };
+
+  CHECK(evaluate("1 + 2 * (7 - 3) - -4") == 13);
+  CHECK(evaluate("100 / 7 / 2") == 7);
+  CHECK(evaluate("!(1 == 2)") == 1);
+  CHECK(evaluate("{ var x = 5; x = 1; 2 * 21 }") == 42);
+  CHECK(evaluate("if 3 < 2 then 10 else { return 20 }") == 20);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+// Evaluator over node ids, no pointer node is built
+class FlatEvaluator : public FlatStaticVisitor<FlatEvaluator, int64_t> {
+ public:
+  using Tree = const FlatTree&;
+  using Id = FlatTree::NodeId;
+
+  int64_t VisitExprStatement(Tree tree, Id id) {
+    return Visit(tree, tree.Children(id)[0]);
+  }
+
+  int64_t VisitAssignment(Tree, Id) {
+    return 0;
+  }
+
+  int64_t VisitVarDecl(Tree, Id) {
+    return 0;
+  }
+
+  int64_t VisitFunDecl(Tree tree, Id id) {
+    return Visit(tree, tree.Children(id).back());
+  }
+
+  int64_t VisitComparison(Tree tree, Id id) {
+    int64_t lhs = Visit(tree, tree.Children(id)[0]);
+    int64_t rhs = Visit(tree, tree.Children(id)[1]);
+
+    switch (tree.GetToken(id).type) {
+      case lex::TokenType::kEquals:
+        return lhs == rhs;
+      case lex::TokenType::kNotEq:
+        return lhs != rhs;
+      case lex::TokenType::kLess:
+        return lhs < rhs;
+      default:
+        return lhs > rhs;
+    }
+  }
+
+  int64_t VisitBinary(Tree tree, Id id) {
+    int64_t lhs = Visit(tree, tree.Children(id)[0]);
+    int64_t rhs = Visit(tree, tree.Children(id)[1]);
+
+    switch (tree.GetToken(id).type) {
+      case lex::TokenType::kPlus:
+        return lhs + rhs;
+      case lex::TokenType::kMinus:
+        return lhs - rhs;
+      case lex::TokenType::kStar:
+        return lhs * rhs;
+      default:
+        return lhs / rhs;
+    }
+  }
+
+  int64_t VisitUnary(Tree tree, Id id) {
+    int64_t operand = Visit(tree, tree.Children(id)[0]);
+    return tree.GetToken(id).type == lex::TokenType::kMinus ? -operand : !operand;
+  }
+
+  int64_t VisitFnCall(Tree, Id) {
+    return 0;
+  }
+
+  int64_t VisitBlock(Tree tree, Id id) {
+    int64_t last = 0;
+    for (auto statement : tree.Children(id)) {
+      last = Visit(tree, statement);
+    }
+    return last;
+  }
+
+  int64_t VisitIf(Tree tree, Id id) {
+    auto children = tree.Children(id);
+    return Visit(tree, children[0]) ? Visit(tree, children[1]) : Visit(tree, children[2]);
+  }
+
+  int64_t VisitLiteral(Tree tree, Id id) {
+    return tree.GetToken(id).value.number;
+  }
+
+  int64_t VisitVarAccess(Tree, Id) {
+    return 0;
+  }
+
+  int64_t VisitReturn(Tree tree, Id id) {
+    return Visit(tree, tree.Children(id)[0]);
+  }
+};
+
+TEST_CASE("FlatStaticVisitor: same results as on pointer nodes", "[ast]") {
+  auto texts = {
+      "1 + 2 * (7 - 3) - -4",
+      "100 / 7 / 2",
+      "!(1 == 2)",
+      "{ var x = 5; x = 1; 2 * 21 }",
+      "if 3 < 2 then 10 else { return 20 }",
+      "f(1, 2) + { 3 != 4 }",
+  };
+
+  for (auto text : texts) {
+    std::stringstream source(text);
+    lex::Lexer l{source};
+    Parser p{l};
+    auto* expr = p.ParseExpression();
+    REQUIRE(expr != nullptr);
+
+    FlatTree tree;
+    auto root = tree.Flatten(expr);
+
+    CHECK(FlatEvaluator{}.Visit(tree, root) == Evaluator{}.Visit(expr));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("StaticVisitor: same traversal as the virtual Visitor", "[ast]") {
+  std::stringstream source("fun f a b = { var c = a * b; c = c + 1; print(c, -a); return c };");
+  lex::Lexer l{source};
+  Parser p{l};
+
+  auto declarations = p.ParseFile();
+  REQUIRE(declarations.size() == 1);
+
+  // Records the kinds in visiting order through either dispatch
+  struct Recorder : StaticVisitor<Recorder> {
+    std::vector<NodeKind> kinds;
+
+    void Record(TreeNode* node) {
+      kinds.push_back(node->GetKind());
+    }
+
+    void VisitExprStatement(ExprStatement* node) {
+      Record(node);
+      Visit(node->expr);
+    }
+    void VisitAssignment(AssignmentStatement* node) {
+      Record(node);
+      Visit(node->lhs);
+      Visit(node->rhs);
+    }
+    void VisitVarDecl(VarDeclStatement* node) {
+      Record(node);
+      Visit(node->rhs);
+    }
+    void VisitFunDecl(FunDeclStatement* node) {
+      Record(node);
+      Visit(node->body);
+    }
+    void VisitComparison(ComparisonExpression* node) {
+      Record(node);
+      Visit(node->lhs);
+      Visit(node->rhs);
+    }
+    void VisitBinary(BinaryExpression* node) {
+      Record(node);
+      Visit(node->lhs);
+      Visit(node->rhs);
+    }
+    void VisitUnary(UnaryExpression* node) {
+      Record(node);
+      Visit(node->operand);
+    }
+    void VisitFnCall(FnCallExpression* node) {
+      Record(node);
+      for (auto* arg : node->args) {
+        Visit(arg);
+      }
+    }
+    void VisitBlock(BlockExpression* node) {
+      Record(node);
+      for (auto* statement : node->statements) {
+        Visit(statement);
+      }
+    }
+    void VisitIf(IfExpression* node) {
+      Record(node);
+      Visit(node->condition_expr);
+      Visit(node->true_expr);
+      Visit(node->false_expr);
+    }
+    void VisitLiteral(LiteralExpression* node) {
+      Record(node);
+    }
+    void VisitVarAccess(VarAccessExpression* node) {
+      Record(node);
+    }
+    void VisitReturn(ReturnExpression* node) {
+      Record(node);
+      Visit(node->expression);
+    }
+  };
+
+  Recorder recorder;
+  recorder.Visit(declarations[0]);
+
+  using enum NodeKind;
+  CHECK(recorder.kinds == std::vector{kFunDecl, kBlock,                                   //
+                                      kVarDecl, kBinary, kVarAccess, kVarAccess,          //
+                                      kAssignment, kVarAccess, kBinary, kVarAccess, kLiteral,  //
+                                      kExprStatement, kFnCall, kVarAccess, kUnary, kVarAccess,
+                                      kExprStatement, kReturn, kVarAccess});
+
+  // The virtual path still prints the same tree
+  std::ostringstream oss;
+  PrintVisitor printer{oss};
+  declarations[0]->Accept(&printer);
+  CHECK(oss.str().starts_with("fun f a b"));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Walker: pre- and post-order hooks", "[ast]") {
+  std::stringstream source("fun f a = { var b = -a; f(b, 2) };");
+  lex::Lexer l{source};
+  Parser p{l};
+
+  auto declarations = p.ParseFile();
+  REQUIRE(declarations.size() == 1);
+
+  struct Trace : Walker<Trace> {
+    std::vector<std::pair<char, NodeKind>> events;
+
+    bool Enter(TreeNode* node) {
+      events.emplace_back('+', node->GetKind());
+      return !isa<VarDeclStatement>(node);  // Skip the initializer
+    }
+
+    void Leave(TreeNode* node) {
+      events.emplace_back('-', node->GetKind());
+    }
+  };
+
+  Trace trace;
+  trace.Walk(declarations[0]);
+
+  using enum NodeKind;
+  CHECK(trace.events == std::vector<std::pair<char, NodeKind>>{
+                            {'+', kFunDecl},
+                            {'+', kBlock},
+                            {'+', kVarDecl},
+                            {'-', kVarDecl},
+                            {'+', kExprStatement},
+                            {'+', kFnCall},
+                            {'+', kVarAccess},
+                            {'-', kVarAccess},
+                            {'+', kLiteral},
+                            {'-', kLiteral},
+                            {'-', kFnCall},
+                            {'-', kExprStatement},
+                            {'-', kBlock},
+                            {'-', kFunDecl},
+                        });
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Walker: deep trees in constant stack depth", "[ast]") {
+  constexpr size_t kDepth = 200'000;
+
+  struct Depth : Walker<Depth> {
+    size_t depth = 0;
+    size_t max_depth = 0;
+    size_t nodes = 0;
+
+    bool Enter(TreeNode*) {
+      ++nodes;
+      max_depth = std::max(max_depth, ++depth);
+      return true;
+    }
+
+    void Leave(TreeNode*) {
+      --depth;
+    }
+  };
+
+  Arena arena;
+
+  // Right-leaning `1 + (1 + (1 + ...))`, built bottom-up
+  Expression* chain = arena.Make<LiteralExpression>(lex::Token{lex::TokenType::kNumber, {.number = 1}});
+  for (size_t i = 0; i < kDepth; ++i) {
+    auto* one = arena.Make<LiteralExpression>(lex::Token{lex::TokenType::kNumber, {.number = 1}});
+    chain = arena.Make<BinaryExpression>(lex::Token{lex::TokenType::kPlus}, one, chain);
+  }
+
+  Depth walker;
+  walker.Walk(chain);
+  CHECK(walker.nodes == 2 * kDepth + 1);
+  CHECK(walker.max_depth == kDepth + 1);
+  CHECK(walker.depth == 0);
+
+  // Blocks nested in blocks
+  Expression* block = arena.Make<BlockExpression>(lex::Token{lex::TokenType::kLeftCBrace}, std::vector<Statement*>{});
+  for (size_t i = 0; i < kDepth; ++i) {
+    auto* statement = arena.Make<ExprStatement>(block);
+    block = arena.Make<BlockExpression>(lex::Token{lex::TokenType::kLeftCBrace}, std::vector<Statement*>{statement});
+  }
+
+  walker.nodes = walker.max_depth = 0;
+  walker.Walk(block);
+  CHECK(walker.nodes == 2 * kDepth + 1);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+// Pre-order numbering of the nodes
+struct Numbering {
+  bool Enter(TreeNode* node) {
+    ids.emplace(node, ids.size());
+    return true;
+  }
+
+  std::unordered_map<TreeNode*, size_t> ids;
+};
+
+// Reads the numbers of the first pass, in post-order
+struct CallSites {
+  using Requires = std::tuple<Numbering>;
+
+  explicit CallSites(const Numbering& numbering) : numbering{numbering} {
+  }
+
+  void Leave(TreeNode* node) {
+    if (isa<FnCallExpression>(node)) {
+      sites.push_back(numbering.ids.at(node));
+    }
+  }
+
+  const Numbering& numbering;
+  std::vector<size_t> sites;
+};
+
+// Counts literals outside of function calls
+struct LiteralsOutsideCalls {
+  bool Enter(TreeNode* node) {
+    literals += isa<LiteralExpression>(node);
+    return !isa<FnCallExpression>(node);
+  }
+
+  void Leave(TreeNode* node) {
+    left += isa<FnCallExpression>(node);
+  }
+
+  size_t literals = 0;
+  size_t left = 0;
+};
+
+TEST_CASE("Fused walker: passes see the same tree as alone", "[ast]") {
+  std::stringstream source(
+      "fun f a = { var b = f(1, g(2)); b = 3 + h(4); if b < 5 then f(6) else 7 };"
+      "var x = f(8) + 9;");
+  lex::Lexer l{source};
+  Parser p{l};
+
+  auto declarations = p.ParseFile();
+  REQUIRE(p.GetErrors().Empty());
+
+  Numbering numbering;
+  CallSites sites{numbering};
+  LiteralsOutsideCalls literals;
+
+  for (auto* declaration : declarations) {
+    FusedWalker{numbering, sites, literals}.Walk(declaration);
+  }
+
+  // Each pass alone
+  Numbering numbering_alone;
+  CallSites sites_alone{numbering_alone};
+  LiteralsOutsideCalls literals_alone;
+
+  for (auto* declaration : declarations) {
+    FusedWalker{numbering_alone}.Walk(declaration);
+  }
+  for (auto* declaration : declarations) {
+    FusedWalker{sites_alone}.Walk(declaration);
+    FusedWalker{literals_alone}.Walk(declaration);
+  }
+
+  CHECK(numbering.ids == numbering_alone.ids);
+  CHECK(sites.sites == sites_alone.sites);
+  CHECK(sites.sites.size() == 5);
+  CHECK(literals.literals == 4);  // 3, 5, 7 and 9
+  CHECK(literals.left == 4);      // Outermost calls, left although skipped
+  CHECK(literals.literals == literals_alone.literals);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Fused walker: skips subtrees no pass wants", "[ast]") {
+  std::stringstream source("{ f(g(h(1)), 2); 3 }");
+  lex::Lexer l{source};
+  Parser p{l};
+  auto* block = p.ParseExpression();
+  REQUIRE(block);
+
+  struct Visited {
+    bool Enter(TreeNode*) {
+      ++nodes;
+      return true;
+    }
+    size_t nodes = 0;
+  };
+
+  // Sees the nodes the walker actually loads
+  struct Probe : Visited {
+    bool Enter(TreeNode* node) {
+      Visited::Enter(node);
+      return !isa<FnCallExpression>(node);
+    }
+  };
+
+  Probe a;
+  LiteralsOutsideCalls b;
+  FusedWalker{a, b}.Walk(block);
+
+  // block, 2 statements, f, literal 3; nothing under `f`
+  CHECK(a.nodes == 5);
+  CHECK(b.literals == 1);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+static std::string DumpFile(const std::string& text, DumpFormat format) {
+  std::stringstream source(text);
+  lex::Lexer l{source};
+  Parser p{l};
+
+  auto declarations = p.ParseFile();
+  REQUIRE(p.GetErrors().Empty());
+
+  Dumper dumper{format};
+  for (auto* declaration : declarations) {
+    dumper.Dump(declaration);
+  }
+  return std::string{dumper.View()};
+}
+
+TEST_CASE("Dumper: source form parses back", "[ast]") {
+  const std::string text =
+      "fun f a b = { var c = (a + b) * -(a - 1); c = c / 2; if c < 1 then g(c, \"s\") else { return c } };\n"
+      "var x = f(1, 2) == (3 + 4);\n"
+      "fun empty = {};\n";
+
+  auto dump = DumpFile(text, DumpFormat::kSource);
+  CHECK(dump ==
+        "fun f a b = {\n"
+        "  var c = (a + b) * -(a - 1);\n"
+        "  c = c / 2;\n"
+        "  if c < 1 then g(c, \"s\") else {\n"
+        "    return c;\n"
+        "  };\n"
+        "};\n"
+        "var x = f(1, 2) == (3 + 4);\n"
+        "fun empty = {};\n");
+
+  CHECK(DumpFile(dump, DumpFormat::kSource) == dump);
+}
+
+TEST_CASE("Dumper: dangling else keeps its if", "[ast]") {
+  const std::string text =
+      "var x = if a then (if b then c) else d;\n"
+      "var y = if a then (if b then c else if e then f) else d;\n"
+      "fun g = if a then (return if b then c) else d;\n"
+      "var z = if a then if b then c else d;\n";
+
+  auto expected = DumpFile(text, DumpFormat::kSExpression);
+
+  auto dump = DumpFile(text, DumpFormat::kSource);
+  CHECK(DumpFile(dump, DumpFormat::kSExpression) == expected);
+
+  // Only where needed
+  CHECK(dump.find("var x = if a then (if b then c) else d;") != std::string::npos);
+  CHECK(dump.find("var z = if a then if b then c else d;") != std::string::npos);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Dumper: S-expressions and JSON Lines", "[ast]") {
+  const std::string text = "var x = -1 + f(y, true); fun g a = if a then 1;";
+
+  CHECK(DumpFile(text, DumpFormat::kSExpression) ==
+        "(var_decl x (binary + (unary - 1) (fn_call f y true)))\n"
+        "(fun_decl g (a) (block (expr_statement (if a 1 ()))))\n");
+
+  CHECK(DumpFile(text, DumpFormat::kJsonLines) ==
+        "{\"kind\":\"var_decl\",\"name\":\"x\",\"children\":[{\"kind\":\"binary\",\"op\":\"+\",\"children\":["
+        "{\"kind\":\"unary\",\"op\":\"-\",\"children\":[{\"kind\":\"literal\",\"value\":1}]},"
+        "{\"kind\":\"fn_call\",\"name\":\"f\",\"children\":[{\"kind\":\"var_access\",\"name\":\"y\"},"
+        "{\"kind\":\"literal\",\"value\":true}]}]}]}\n"
+        "{\"kind\":\"fun_decl\",\"name\":\"g\",\"params\":[\"a\"],\"children\":[{\"kind\":\"block\",\"children\":["
+        "{\"kind\":\"expr_statement\",\"children\":[{\"kind\":\"if\",\"children\":["
+        "{\"kind\":\"var_access\",\"name\":\"a\"},{\"kind\":\"literal\",\"value\":1},null]}]}]}]}\n");
+
+  // Strings are escaped
+  CHECK(DumpFile("var s = \"a\\b\nc\";", DumpFormat::kJsonLines).find(R"("value":"a\\b\nc")") != std::string::npos);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Dumper: streams to a file descriptor in chunks", "[ast]") {
+  std::string text;
+  for (int i = 0; i < 2000; ++i) {
+    text += fmt::format("fun f{} a = {{ var b = a * {} + g(a, {}); return b }};\n", i, i, i + 1);
+  }
+
+  std::stringstream source(text);
+  lex::Lexer l{source};
+  Parser p{l};
+  auto declarations = p.ParseFile();
+
+  auto path = std::filesystem::temp_directory_path() / fmt::format("dump_{}.jsonl", ::getpid());
+
+  Dumper in_memory{DumpFormat::kJsonLines};
+  {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    REQUIRE(file);
+
+    Dumper streaming{::fileno(file), DumpFormat::kJsonLines};
+    for (auto* declaration : declarations) {
+      streaming.Dump(declaration);
+      in_memory.Dump(declaration);
+
+      // Never more than a chunk and one item held back
+      CHECK(streaming.View().size() < Dumper::kChunkSize + 1024);
+    }
+    streaming.Flush();
+
+    std::fclose(file);
+  }
+
+  CHECK(in_memory.View().size() > 4 * Dumper::kChunkSize);
+
+  std::ifstream file{path};
+  std::string written{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+  CHECK(written == in_memory.View());
+
+  std::filesystem::remove(path);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Serialization: round trip", "[ast]") {
+  const std::string text =
+      "fun f a b = { var c = (a + b) * -(a - 1); c = c / 2; if c < 1 then g(c, \"s\") else { return c } };\n"
+      "var x = f(1, 2) == (3 + 4);\n"
+      "fun h = if true then 1;\n";
+  auto path = WriteTempSource("serialize_source.et", text);
+
+  lex::Lexer l{path};
+  Parser p{l};
+  auto declarations = p.ParseFile();
+  REQUIRE(p.GetErrors().Empty());
+
+  std::vector<TreeNode*> roots{declarations.begin(), declarations.end()};
+  auto bytes = EncodeAst(roots);
+
+  Arena arena;
+  auto loaded = DecodeAst(bytes, arena);
+  REQUIRE(loaded.size() == roots.size());
+
+  for (size_t i = 0; i < roots.size(); ++i) {
+    CHECK(DumpToString(loaded[i], DumpFormat::kSExpression) == DumpToString(roots[i], DumpFormat::kSExpression));
+    CHECK(loaded[i]->GetLocation().offset == roots[i]->GetLocation().offset);
+  }
+
+  // Same file name, symbols are the same session symbols
+  auto* fun = cast<FunDeclStatement>(loaded[0]);
+  CHECK(lex::SourceMap::Session().FileName(fun->name.location.file_id) == path.string());
+  CHECK(fun->name.value.identifier == cast<FunDeclStatement>(roots[0])->name.value.identifier);
+
+  // Through a file and a mapping
+  auto ast_path = path;
+  ast_path.replace_extension(".east");
+  WriteAst(ast_path, roots);
+
+  Arena mapped_arena;
+  auto mapped = ReadAst(ast_path, mapped_arena);
+  REQUIRE(mapped.size() == roots.size());
+  CHECK(DumpToString(mapped[2], DumpFormat::kSource) == DumpToString(roots[2], DumpFormat::kSource));
+
+  std::filesystem::remove(path);
+  std::filesystem::remove(ast_path);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Serialization: damaged input is rejected", "[ast]") {
+  std::stringstream source("var x = f(1, y);");
+  lex::Lexer l{source};
+  Parser p{l};
+  auto declarations = p.ParseFile();
+
+  std::vector<TreeNode*> roots{declarations.begin(), declarations.end()};
+  auto bytes = EncodeAst(roots);
+
+  Arena arena;
+
+  auto damaged = bytes;
+  damaged[0] = 'X';
+  CHECK_THROWS_AS(DecodeAst(damaged, arena), AstReadError);
+
+  damaged = bytes;
+  damaged[4] = 99;  // version
+  CHECK_THROWS_AS(DecodeAst(damaged, arena), AstReadError);
+
+  damaged = bytes;
+  damaged.resize(bytes.size() - 1);
+  CHECK_THROWS_AS(DecodeAst(damaged, arena), AstReadError);
+
+  damaged = bytes;
+  damaged.resize(10);
+  CHECK_THROWS_AS(DecodeAst(damaged, arena), AstReadError);
+
+  // Well-formed bytes, but a number where a name belongs
+  TreeNode* misnamed[] = {arena.Make<VarAccessExpression>(lex::Token{lex::TokenType::kNumber, {.number = 1}})};
+  CHECK_THROWS_AS(DecodeAst(EncodeAst(misnamed), arena), AstReadError);
+
+  // ... and a comparison operator on a binary expression
+  auto* one = arena.Make<LiteralExpression>(lex::Token{lex::TokenType::kNumber, {.number = 1}});
+  TreeNode* misoperated[] = {arena.Make<BinaryExpression>(lex::Token{lex::TokenType::kLess}, one, one)};
+  CHECK_THROWS_AS(DecodeAst(EncodeAst(misoperated), arena), AstReadError);
+
+  CHECK(DecodeAst(bytes, arena).size() == 1);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+static std::string BenchSource(size_t functions) {
+  std::string text;
+  for (size_t i = 0; i < functions; ++i) {
+    text += fmt::format(
+        "fun f{} a b = {{\n"
+        "  var c = (a + b) * -(a - {}) / g(a, b, \"text\");\n"
+        "  c = c + h(c * 2, a == b);\n"
+        "  if c < {} then f(c, b) else {{ return c - 1 }}\n"
+        "}};\n",
+        i, i, i + 1);
+  }
+  return text;
+}
+
+template <typename F>
+static double MedianMillis(F&& run, int repetitions = 5) {
+  std::vector<double> times;
+  for (int i = 0; i < repetitions; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    run();
+    times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+  }
+  std::sort(times.begin(), times.end());
+  return times[times.size() / 2];
+}
+
+TEST_CASE("Serialization: load time against parsing", "[.][bench]") {
+  auto path = WriteTempSource("bench_source.et", BenchSource(20'000));
+
+  std::vector<TreeNode*> roots;
+  Arena source_arena;
+  {
+    lex::Lexer l{path};
+    Parser p{l, source_arena};
+    auto declarations = p.ParseFile();
+    roots.assign(declarations.begin(), declarations.end());
+  }
+
+  auto ast_path = path;
+  ast_path.replace_extension(".east");
+  WriteAst(ast_path, roots);
+
+  size_t nodes = 0;
+
+  double parse = MedianMillis([&] {
+    Arena arena;
+    lex::Lexer l{path};
+    Parser p{l, arena};
+    nodes += p.ParseFile().size();
+  });
+
+  double load = MedianMillis([&] {
+    Arena arena;
+    nodes += ReadAst(ast_path, arena).size();
+  });
+
+  fmt::print("source {} KiB, ast {} KiB\n", std::filesystem::file_size(path) / 1024,
+             std::filesystem::file_size(ast_path) / 1024);
+  fmt::print("lex + parse {:.1f} ms, load {:.1f} ms ({:.1f}x)\n", parse, load, parse / load);
+
+  CHECK(nodes > 0);
+
+  std::filesystem::remove(path);
+  std::filesystem::remove(ast_path);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Hash: content keys", "[cache]") {
+  CHECK(util::HashBytes("") != util::HashBytes(std::string_view{"\0", 1}));
+  CHECK(util::HashBytes("abc") == util::HashBytes(std::string{"abc"}));
+
+  // Every length up to a few blocks, every single-bit flip
+  std::string text(70, 'x');
+  for (size_t length = 0; length <= text.size(); ++length) {
+    auto base = util::HashBytes(std::string_view{text}.substr(0, length));
+    for (size_t i = 0; i < length; ++i) {
+      std::string flipped = text.substr(0, length);
+      flipped[i] ^= 1;
+      CHECK(util::HashBytes(flipped) != base);
+    }
+  }
+
+  auto key = cache::ContentKey::Of("var x = 1;");
+  CHECK(key.size == 10);
+  CHECK(key.FileName("ast1") == fmt::format("{:016x}-a.ast1", key.hash));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Cache: second parse skips the front-end", "[cache]") {
+  auto directory = std::filesystem::temp_directory_path() / fmt::format("et_cache_{}", ::getpid());
+  std::filesystem::remove_all(directory);
+  cache::ArtifactCache cache{directory};
+
+  const std::string text = "fun f a = { var b = a * 2; g(b, \"s\") };\nvar x = f(1);\n";
+  auto path = WriteTempSource("cached_source.et", text);
+
+  Arena arena;
+
+  auto first = cache::ParseCached(path, cache, arena);
+  CHECK_FALSE(first.hit);
+  CHECK(first.errors.empty());
+  REQUIRE(first.declarations.size() == 2);
+
+  auto second = cache::ParseCached(path, cache, arena);
+  CHECK(second.hit);
+  REQUIRE(second.declarations.size() == 2);
+
+  for (size_t i = 0; i < 2; ++i) {
+    CHECK(DumpToString(second.declarations[i], DumpFormat::kSource) ==
+          DumpToString(first.declarations[i], DumpFormat::kSource));
+  }
+  CHECK(second.declarations[1]->GetLocation().Format() == first.declarations[1]->GetLocation().Format());
+
+  SECTION("same contents under another name") {
+    auto copy = WriteTempSource("cached_copy.et", text);
+    auto third = cache::ParseCached(copy, cache, arena);
+    CHECK(third.hit);
+    CHECK(lex::SourceMap::Session().FileName(third.declarations[0]->GetLocation().file_id) == copy.string());
+    std::filesystem::remove(copy);
+  }
+
+  SECTION("an edit misses") {
+    WriteTempSource("cached_source.et", text + "var y = 2;\n");
+    auto edited = cache::ParseCached(path, cache, arena);
+    CHECK_FALSE(edited.hit);
+    CHECK(edited.declarations.size() == 3);
+  }
+
+  SECTION("a damaged entry is a miss and gets replaced") {
+    for (auto& entry : std::filesystem::directory_iterator{directory}) {
+      std::ofstream{entry.path(), std::ios::trunc} << "garbage";
+    }
+
+    CHECK_FALSE(cache::ParseCached(path, cache, arena).hit);
+    CHECK(cache::ParseCached(path, cache, arena).hit);
+  }
+
+  SECTION("files with errors are not stored") {
+    auto broken = WriteTempSource("cached_broken.et", "var = 1;");
+    auto parsed = cache::ParseCached(broken, cache, arena);
+    CHECK_FALSE(parsed.errors.empty());
+    CHECK_FALSE(cache::ParseCached(broken, cache, arena).hit);
+    std::filesystem::remove(broken);
+  }
+
+  std::filesystem::remove(path);
+  std::filesystem::remove_all(directory);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Cache: concurrent writers of one entry", "[cache]") {
+  auto directory = std::filesystem::temp_directory_path() / fmt::format("et_cache_race_{}", ::getpid());
+  std::filesystem::remove_all(directory);
+  cache::ArtifactCache cache{directory};
+
+  auto key = cache::ContentKey::Of("source");
+  std::string bytes(1 << 20, 'a');
+
+  // Assertions are not thread-safe, count on the side
+  std::atomic<size_t> failed_stores{0};
+  std::atomic<size_t> torn_reads{0};
+
+  std::vector<std::thread> writers;
+  for (int i = 0; i < 8; ++i) {
+    writers.emplace_back([&] {
+      for (int j = 0; j < 10; ++j) {
+        failed_stores += !cache.Store(key, "blob", bytes);
+
+        // Readers never see a partial entry
+        if (auto entry = cache.Load(key, "blob")) {
+          torn_reads += (entry->View() != bytes);
+        }
+      }
+    });
+  }
+  for (auto& writer : writers) {
+    writer.join();
+  }
+
+  CHECK(failed_stores == 0);
+  CHECK(torn_reads == 0);
+
+  // No temporaries left behind
+  size_t entries = 0;
+  for ([[maybe_unused]] auto& entry : std::filesystem::directory_iterator{directory}) {
+    ++entries;
+  }
+  CHECK(entries == 1);
+
+  std::filesystem::remove_all(directory);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+static Expression* ParseExpressionOf(std::string text, Arena& arena, bool consing = false) {
+  std::stringstream source(std::move(text));
+  lex::Lexer l{source};
+  Parser p{l, arena};
+  if (consing) {
+    p.EnableHashConsing();
+  }
+  return p.ParseExpression();
+}
+
+TEST_CASE("Structural hash: locations do not matter", "[ast]") {
+  Arena arena;
+  auto* a = ParseExpressionOf("(x + 1) * f(y, \"s\")", arena);
+  auto* b = ParseExpressionOf("  ( x+1 )*f( y,\"s\" )", arena);
+  REQUIRE(a != nullptr);
+  REQUIRE(b != nullptr);
+
+  CHECK(StructuralHash(a) == StructuralHash(b));
+  CHECK(StructurallyEqual(a, b));
+
+  // Cached on the nodes
+  CHECK(a->structural_hash != 0);
+  CHECK(cast<BinaryExpression>(a)->lhs->structural_hash != 0);
+
+  for (auto* other : {"(x + 1) * f(y, \"t\")", "(x - 1) * f(y, \"s\")", "(x + 2) * f(y, \"s\")",
+                      "(z + 1) * f(y, \"s\")", "(x + 1) * g(y, \"s\")", "(x + 1) * f(y)", "x + 1 * f(y, \"s\")"}) {
+    auto* c = ParseExpressionOf(other, arena);
+    REQUIRE(c != nullptr);
+    CHECK(StructuralHash(a) != StructuralHash(c));
+    CHECK_FALSE(StructurallyEqual(a, c));
+  }
+}
+
+TEST_CASE("Structural hash: blocks and conditionals", "[ast]") {
+  Arena arena;
+  auto* a = ParseExpressionOf("{ var v = 1; v = v + 2; if v < 3 then v }", arena);
+  auto* b = ParseExpressionOf("{var v=1;v=v+2;if v<3 then v}", arena);
+  auto* c = ParseExpressionOf("{ var v = 1; v = v + 2; if v < 3 then v else v }", arena);
+  auto* d = ParseExpressionOf("{ var w = 1; v = v + 2; if v < 3 then v }", arena);
+  REQUIRE((a && b && c && d));
+
+  CHECK(StructurallyEqual(a, b));
+  CHECK_FALSE(StructurallyEqual(a, c));
+  CHECK_FALSE(StructurallyEqual(a, d));
+}
+
+TEST_CASE("Hash-consing: shares pure subtrees only", "[parse]") {
+  Arena arena;
+  std::stringstream source("f(a * b + 1, a * b + 1, g(a), g(a), -a == -a)");
+  lex::Lexer l{source};
+  Parser p{l, arena};
+  p.EnableHashConsing();
+
+  auto* call = dyn_cast<FnCallExpression>(p.ParseExpression());
+  REQUIRE(call != nullptr);
+  REQUIRE(call->args.size() == 5);
+
+  CHECK(call->args[0] == call->args[1]);
+  CHECK(call->args[2] != call->args[3]);
+  CHECK(StructurallyEqual(call->args[2], call->args[3]));
+
+  auto* cmp = cast<ComparisonExpression>(call->args[4]);
+  CHECK(cmp->lhs == cmp->rhs);
+
+  // `a`, `b`, `a * b`, `1`, `a * b + 1`, `-a`, the comparison
+  REQUIRE(p.GetConser() != nullptr);
+  CHECK(p.GetConser()->Size() == 7);
+  CHECK(p.GetConser()->Hits() > 0);
+}
+
+TEST_CASE("Hash-consing: fewer nodes on repetitive input", "[parse]") {
+  std::string text = "fun f x = {";
+  for (int i = 0; i < 200; ++i) {
+    text += " x = x * (x + 1) - 2 * x;";
+  }
+  text += " x };";
+
+  auto parse = [&text](bool consing) {
+    Arena arena;
+    std::stringstream source(text);
+    lex::Lexer l{source};
+    Parser p{l, arena};
+    if (consing) {
+      p.EnableHashConsing();
+    }
+    auto declarations = p.ParseFile();
+    REQUIRE(p.GetErrors().Empty());
+    REQUIRE(declarations.size() == 1);
+    return std::pair{arena.BytesAllocated(), DumpToString(declarations[0], DumpFormat::kSExpression)};
+  };
+
+  auto [plain_bytes, plain_dump] = parse(false);
+  auto [consed_bytes, consed_dump] = parse(true);
+
+  // Same program, read through the DAG
+  CHECK(plain_dump == consed_dump);
+  CHECK(consed_bytes * 2 < plain_bytes);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Symbol table: shadowing and scopes", "[sema]") {
+  sema::SymbolTable table;
+  lex::Symbol x{"x"};
+  lex::Symbol y{"y"};
+
+  VarDeclStatement outer{lex::Token{}, nullptr};
+  VarDeclStatement inner{lex::Token{}, nullptr};
+
+  CHECK(table.Lookup(x) == nullptr);
+  CHECK(table.Bind(x, {sema::SymbolKind::kVariable, &outer}));
+
+  table.Enter();
+  CHECK(table.Lookup(x)->declaration == &outer);
+  CHECK(table.Lookup(x)->depth == 0);
+
+  CHECK(table.Bind(x, {sema::SymbolKind::kVariable, &inner}));
+  CHECK(table.Bind(y, {sema::SymbolKind::kParameter, &inner}));
+  CHECK(table.Lookup(x)->declaration == &inner);
+  CHECK(table.Lookup(x)->depth == 1);
+
+  // Same scope: reported, still shadows
+  CHECK_FALSE(table.Bind(y, {sema::SymbolKind::kVariable, &outer}));
+  CHECK(table.Lookup(y)->kind == sema::SymbolKind::kVariable);
+
+  table.Enter();
+  table.Enter();
+  CHECK(table.Depth() == 3);
+  CHECK(table.Lookup(x)->declaration == &inner);
+  table.Exit();
+  table.Exit();
+
+  table.Exit();
+  CHECK(table.Depth() == 0);
+  CHECK(table.Lookup(x)->declaration == &outer);
+  CHECK(table.Lookup(y) == nullptr);
+  CHECK(table.Size() == 1);
+}
+
+TEST_CASE("Symbol table: many names", "[sema]") {
+  sema::SymbolTable table;
+  VarDeclStatement declaration{lex::Token{}, nullptr};
+
+  std::vector<lex::Symbol> names;
+  for (int i = 0; i < 5000; ++i) {
+    names.emplace_back(fmt::format("name_{}", i));
+  }
+
+  // One scope per name, every name visible from the innermost one
+  for (auto name : names) {
+    table.Enter();
+    table.Bind(name, {sema::SymbolKind::kVariable, &declaration});
+  }
+
+  size_t found = 0;
+  for (size_t i = 0; i < names.size(); ++i) {
+    auto* info = table.Lookup(names[i]);
+    found += (info != nullptr && info->depth == i + 1);
+  }
+  CHECK(found == names.size());
+
+  for (size_t i = 0; i < names.size() / 2; ++i) {
+    table.Exit();
+  }
+  CHECK(table.Lookup(names.front()) != nullptr);
+  CHECK(table.Lookup(names.back()) == nullptr);
+  CHECK(table.Size() == names.size() / 2);
+}
+
+TEST_CASE("Name resolution: scoping rules", "[sema]") {
+  Arena arena;
+  std::stringstream source(
+      "fun even n = if n == 0 then true else odd(n - 1);\n"
+      "fun odd n = if n == 0 then false else even(n - 1);\n"
+      "var g = 1;\n"
+      "fun f x = { var x = x + g; { var y = x; y }; y + z };\n"
+      "fun h a a = { var b = 1; var b = 2; b };\n"
+      "fun k = { fun g n = if n == 0 then 1 else g(n - 1); fun g2 = g(1); g2() + w() };\n"
+      "fun l = { { fun inner = 1; }; inner() };\n");
+  lex::Lexer l{source};
+  Parser p{l, arena};
+  auto declarations = p.ParseFile();
+  REQUIRE(p.GetErrors().Empty());
+
+  auto errors = sema::ResolveNames(declarations);
+
+  std::vector<std::string> unbound;
+  for (auto& token : errors.unbound) {
+    unbound.emplace_back(lex::Interner::Session().View(token.value.identifier.id));
+  }
+  CHECK(unbound == std::vector<std::string>{"y", "z", "w", "inner"});
+  CHECK(errors.redeclared.size() == 2);
+}
+
+// Naive layout for comparison: a map per scope, lookups walk outwards
+class ChainedSymbolTable {
+ public:
+  ChainedSymbolTable() : scopes_(1) {
+  }
+
+  void Enter() {
+    scopes_.emplace_back();
+  }
+
+  void Exit() {
+    scopes_.pop_back();
+  }
+
+  void Bind(lex::Symbol name, sema::SymbolInfo info) {
+    scopes_.back()[name.id] = info;
+  }
+
+  const sema::SymbolInfo* Lookup(lex::Symbol name) const {
+    for (auto scope = scopes_.rbegin(); scope != scopes_.rend(); ++scope) {
+      if (auto it = scope->find(name.id); it != scope->end()) {
+        return &it->second;
+      }
+    }
+    return nullptr;
+  }
+
+ private:
+  std::vector<std::unordered_map<lex::SymbolId, sema::SymbolInfo>> scopes_;
+};
+
+TEST_CASE("Symbol table: deep nesting against scope chains", "[.][bench]") {
+  constexpr size_t kDepth = 2'000;
+  constexpr size_t kLocals = 8;
+  constexpr size_t kLookups = 32;
+
+  VarDeclStatement declaration{lex::Token{}, nullptr};
+
+  std::vector<lex::Symbol> names;
+  for (size_t i = 0; i < kDepth * kLocals; ++i) {
+    names.emplace_back(fmt::format("local_{}", i));
+  }
+
+  // Every block binds its locals and reads names of blocks all the way
+  // out, the shape of a long chain of nested `{ var ...; ... }`
+  auto run = [&](auto& table) {
+    size_t found = 0;
+    for (size_t depth = 0; depth < kDepth; ++depth) {
+      table.Enter();
+      for (size_t i = 0; i < kLocals; ++i) {
+        table.Bind(names[depth * kLocals + i], {sema::SymbolKind::kVariable, &declaration});
+      }
+      for (size_t i = 0; i < kLookups; ++i) {
+        found += table.Lookup(names[(i * 7919) % ((depth + 1) * kLocals)]) != nullptr;
+      }
+    }
+    for (size_t depth = 0; depth < kDepth; ++depth) {
+      table.Exit();
+    }
+    return found;
+  };
+
+  size_t found = 0;
+
+  double flat = MedianMillis([&] {
+    sema::SymbolTable table;
+    found += run(table);
+  });
+
+  double chained = MedianMillis([&] {
+    ChainedSymbolTable table;
+    found += run(table);
+  });
+
+  // The resolver on a parsed program. Blocks still recurse in the
+  // parser, so the program is shallower than the table run above.
+  constexpr size_t kParsedDepth = 400;
+
+  std::string text = "fun f p = ";
+  for (size_t depth = 0; depth < kParsedDepth; ++depth) {
+    text += fmt::format("{{ var v{} = p; ", depth);
+  }
+  for (size_t depth = kParsedDepth; depth-- > 0;) {
+    text += fmt::format("{}v{} + v0 }}", depth + 1 < kParsedDepth ? "; " : "", depth);
+  }
+  text += ";";
+
+  Arena arena;
+  std::stringstream source(text);
+  lex::Lexer l{source};
+  Parser p{l, arena};
+  auto declarations = p.ParseFile();
+  REQUIRE(p.GetErrors().Empty());
+
+  sema::NameErrors errors;
+  double resolve = MedianMillis([&] {
+    errors = sema::ResolveNames(declarations);
+  });
+
+  fmt::print("{} scopes x {} locals: flat {:.2f} ms, chained {:.2f} ms ({:.1f}x)\n", kDepth, kLocals, flat, chained,
+             chained / flat);
+  fmt::print("resolving {} nested blocks: {:.2f} ms\n", kParsedDepth, resolve);
+
+  CHECK(found == 2 * 5 * kDepth * kLookups);
+  CHECK(errors.Empty());
+}